@@ -51,3 +51,76 @@ ece391_strncmp (const uint8_t* s1, const uint8_t* s2, uint32_t n)
     return ((int32_t)*s1) - ((int32_t)*s2);
 }
 
+/* Every heap block starts with this header, blocks are kept in address order */
+typedef struct heap_block {
+    uint32_t size;
+    uint32_t free;
+    struct heap_block* next;
+} heap_block_t;
+
+#define HEAP_ALIGN 8
+
+static heap_block_t* heap_head = 0;
+static heap_block_t* heap_tail = 0;
+
+/* First-fit allocator on top of the sbrk system call */
+void*
+ece391_malloc (uint32_t size)
+{
+    heap_block_t* block;
+    heap_block_t* rest;
+
+    if (0 == size)
+        return 0;
+    size = (size + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+
+    /* reuse a free block, splitting it if the rest is big enough */
+    for (block = heap_head; 0 != block; block = block->next) {
+        if (!block->free || block->size < size)
+            continue;
+        if (block->size >= size + sizeof(heap_block_t) + HEAP_ALIGN) {
+            rest = (heap_block_t*)((uint8_t*)(block + 1) + size);
+            rest->size = block->size - size - sizeof(heap_block_t);
+            rest->free = 1;
+            rest->next = block->next;
+            if (heap_tail == block)
+                heap_tail = rest;
+            block->next = rest;
+            block->size = size;
+        }
+        block->free = 0;
+        return block + 1;
+    }
+
+    /* otherwise grow the heap */
+    block = ece391_sbrk (sizeof(heap_block_t) + size);
+    if ((void*)-1 == block)
+        return 0;
+    block->size = size;
+    block->free = 0;
+    block->next = 0;
+    if (0 == heap_head)
+        heap_head = block;
+    else
+        heap_tail->next = block;
+    heap_tail = block;
+    return block + 1;
+}
+
+/* Mark a block free and merge it with the free blocks that follow it */
+void
+ece391_free (void* ptr)
+{
+    heap_block_t* block;
+
+    if (0 == ptr)
+        return;
+    block = (heap_block_t*)ptr - 1;
+    block->free = 1;
+    while (0 != block->next && block->next->free) {
+        if (heap_tail == block->next)
+            heap_tail = block;
+        block->size += sizeof(heap_block_t) + block->next->size;
+        block->next = block->next->next;
+    }
+}
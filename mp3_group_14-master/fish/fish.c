@@ -5,9 +5,24 @@
 
 #define NULL 0
 #define WAIT 100
+#define READ_CHUNK 64
+
+/* a frame file read a chunk at a time, both files are refilled with one
+   trap through the io ring */
+struct frame_reader {
+    int32_t fd;
+    int32_t len;
+    int32_t pos;
+    int32_t eof;
+    uint8_t buf[READ_CHUNK];
+};
+
+static ece391_ring_t* ring = NULL;
 uint8_t *vmem_base_addr;
 uint8_t *mp1_set_video_mode (void);
 void add_frames(uint8_t *, uint8_t *, int32_t);
+void fill_readers(struct frame_reader* rd, int32_t n);
+int32_t next_char(struct frame_reader* rd, uint8_t* c);
 void ece391_memset(void* memory, char c, int n);
 int32_t ece391_memcpy(void* dest, const void* src, int32_t n);
 
@@ -18,15 +33,11 @@ uint8_t file1[] = "frame1.txt";
 extern int mp1_ioctl(unsigned long arg, unsigned long cmd);
 extern void mp1_rtc_tasklet(unsigned long trash);
 
-static struct mp1_blink_struct blink_array[80*25];
-
 int main(void)
 {
     int rtc_fd, ret_val, i, garbage;
     struct mp1_blink_struct blink_struct;
 
-    ece391_memset(blink_array, 0, sizeof(struct mp1_blink_struct)*80*25);
-
     if(mp1_set_video_mode() == NULL) {
         return -1;
     }
@@ -78,8 +89,9 @@ int main(void)
 void
 add_frames(uint8_t *f0, uint8_t *f1, int32_t rtc_fd)
 {
-    int32_t row, col, offset = 40, eof0 = 0, eof1 = 0, num_bytes;
+    int32_t row, col, offset = 40, eof0 = 0, eof1 = 0;
     int32_t fd0, fd1;
+    struct frame_reader rd[2];
     struct mp1_blink_struct blink_struct;
     uint8_t c0 = '0', c1 = '0';
 
@@ -95,21 +107,28 @@ add_frames(uint8_t *f0, uint8_t *f1, int32_t rtc_fd)
         ece391_halt(-1);
     }
 
+    ring = ece391_ring_setup();
+    if(ring == (ece391_ring_t*)-1) {
+        ring = NULL;
+    }
+    ece391_memset(rd, 0, sizeof(rd));
+    rd[0].fd = fd0;
+    rd[1].fd = fd1;
+
     while(eof0 == 0 || eof1 == 0) {
         col = 0;
         while(1) {
+            fill_readers(rd, 2);
 
             if(c0 != '\n') {
-                num_bytes = ece391_read(fd0, &c0, 1);
-                if(num_bytes == 0) {
+                if(next_char(&rd[0], &c0) == 0) {
                     c0 = '\n';
                     eof0 = 1;
                 }
             }
 
             if(c1 != '\n') {
-                num_bytes = ece391_read(fd1, &c1, 1);
-                if(num_bytes == 0) {
+                if(next_char(&rd[1], &c1) == 0) {
                     c1 = '\n';
                     eof1 = 1;
                 }
@@ -147,6 +166,68 @@ add_frames(uint8_t *f0, uint8_t *f1, int32_t rtc_fd)
     }
 }
 
+/*
+ * fill_readers
+ * refill the readers that ran dry, all with one ring_enter, or with one
+ * read each when there is no ring
+ */
+void
+fill_readers(struct frame_reader* rd, int32_t n)
+{
+    int32_t i, queued = 0;
+    ece391_sqe_t* sqe;
+    ece391_cqe_t* cqe;
+
+    for(i = 0; i < n; i++) {
+        if(rd[i].pos < rd[i].len || rd[i].eof) {
+            continue;
+        }
+        if(ring == NULL) {
+            rd[i].len = ece391_read(rd[i].fd, rd[i].buf, READ_CHUNK);
+            rd[i].pos = 0;
+            rd[i].eof = (rd[i].len <= 0);
+            continue;
+        }
+        sqe = &ring->sq[ring->sq_tail % RING_ENTRIES];
+        sqe->opcode = RING_OP_READ;
+        sqe->fd = rd[i].fd;
+        sqe->buf = rd[i].buf;
+        sqe->len = READ_CHUNK;
+        sqe->user_data = i;
+        ring->sq_tail++;
+        queued++;
+    }
+
+    if(queued == 0) {
+        return;
+    }
+    ece391_ring_enter(queued);
+
+    while(ring->cq_head != ring->cq_tail) {
+        cqe = &ring->cq[ring->cq_head % RING_ENTRIES];
+        i = cqe->user_data;
+        rd[i].len = cqe->result;
+        rd[i].pos = 0;
+        rd[i].eof = (cqe->result <= 0);
+        ring->cq_head++;
+    }
+}
+
+/*
+ * next_char
+ * take the next byte of a reader filled by fill_readers, 0 at the end of
+ * the file
+ */
+int32_t
+next_char(struct frame_reader* rd, uint8_t* c)
+{
+    if(rd->pos >= rd->len) {
+        return 0;
+    }
+    *c = rd->buf[rd->pos++];
+    return 1;
+}
+
 uint8_t*
 mp1_set_video_mode (void)
 {
@@ -159,19 +240,12 @@ mp1_set_video_mode (void)
 
 void* mp1_malloc(int32_t size)
 {
-    int32_t i;
-    for(i=0; i< 80*25; i++) {
-        if(blink_array[i].location == 0) {
-            return &blink_array[i];
-        }
-    }
-
-    return NULL;
+    return ece391_malloc(size);
 }
 
 void mp1_free(void* memory)
 {
-    ece391_memset(memory, 0, sizeof(struct mp1_blink_struct));
+    ece391_free(memory);
 }
 
 void ece391_memset(void* memory, char c, int n)
@@ -0,0 +1,602 @@
+/* harness.c - Checks and benchmarks for the kernel's file system, string
+ * routines and keyboard line discipline, run as a Linux program.
+ * usage: harness <filesys_img> <fsdir> [seed]
+ * The files in the image are compared against the copies in fsdir, the
+ * rest is fuzzed against libc and invariants. Exits 1 if a check fails.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PASS 1
+#define FAIL 0
+
+#define TEST_OUTPUT(name, result)	\
+	printf("[TEST %s] Result = %s\n", name, (result) ? "PASS" : "FAIL");
+
+// from file_system.h, keyboard.h and lib.c
+#define FILE_NAME_LEN       32
+#define TYPE_FILE           2
+#define KEY_BUFFER_SIZE     128
+#define NUM_COLS            80
+#define NUM_ROWS            25
+#define BLOCKS_SIZE         4096
+#define DIRENT_ALIGN        4
+// small enough that a listing takes several calls
+#define DIRENT_BUF_SIZE     100
+
+// the largest program execute loads
+#define MAX_FILE_SIZE       0x400000
+#define PATH_SIZE           256
+#define FUZZ_ROUNDS         100000
+#define STRING_SIZE         1024
+#define STRING_MAX_LEN      512
+#define BENCH_RUNS          101
+#define BENCH_COPY_SIZE     4096
+#define BENCH_FILE          "hello"
+#define BENCH_BIG_FILE      "fish"
+
+// scancodes the keyboard fuzz leans on, see keyboard.h
+#define SCANCODE_RELEASE    0x80
+#define SCANCODE_FIRST_KEY  0x02
+#define SCANCODE_LAST_KEY   0x39
+#define SCANCODE_ENTER      0x1C
+#define SCANCODE_BACKSPACE  0x0E
+
+/* module_t of multiboot.h and dentry_t of file_system.h */
+typedef struct host_module {
+	uint32_t mod_start;
+	uint32_t mod_end;
+	uint32_t string;
+	uint32_t reserved;
+} host_module_t;
+
+typedef struct host_dentry {
+	uint8_t file_name[FILE_NAME_LEN];
+	uint32_t file_type;
+	uint32_t inodes;
+	uint8_t reserved[24];
+} host_dentry_t;
+
+/* dirent_t of file_system.h */
+typedef struct host_dirent {
+	uint16_t reclen;
+	uint8_t type;
+	uint8_t namelen;
+	uint32_t inode;
+	uint32_t length;
+	uint8_t name[];
+} host_dirent_t;
+
+/* the kernel code, prefixed with k_ by the Makefile */
+extern void k_init_file_system(host_module_t *module);
+extern int32_t k_read_dentry_by_name(const uint8_t *fname, host_dentry_t *dentry);
+extern int32_t k_read_dentry_by_index(uint32_t index, host_dentry_t *dentry);
+extern int32_t k_read_data(uint32_t inode, uint32_t offset, uint8_t *buf, uint32_t length);
+extern uint32_t k_get_length(uint32_t inode);
+extern int32_t k_read_dirents(uint32_t *position, uint8_t *buf, uint32_t length);
+extern int32_t k_send_data(uint32_t inode, uint32_t offset, uint32_t length,
+	int32_t (*write)(), int32_t out_fd);
+extern void *k_memcpy(void *dest, const void *src, uint32_t n);
+extern void *k_memmove(void *dest, const void *src, uint32_t n);
+extern void *k_memset(void *s, int32_t c, uint32_t n);
+extern int32_t k_strncmp(const char *s1, const char *s2, uint32_t n);
+extern uint32_t k_strlen(const char *s);
+extern void k_set_video_mem(uint32_t addr);
+extern void k_putc(uint8_t c);
+extern void k_scroll(void);
+extern void k_clear(void);
+extern int k_get_x(void);
+extern int k_get_y(void);
+extern void k_set_x(int32_t x);
+extern void k_set_y(int32_t y);
+extern void k_keyboard_scancode(uint8_t key_pressed);
+extern char *k_get_keyboard_buffer(void);
+extern int k_get_buffer_ptr(void);
+extern int32_t k_host_take_line(char *buf, int32_t nbytes);
+
+/* All of these are handed to the kernel code, which needs them below 4GB.
+ * Static storage is, since the program is not position independent. */
+static host_module_t module;
+static uint16_t video[NUM_ROWS * NUM_COLS];
+static uint8_t file_buf[MAX_FILE_SIZE];
+static uint8_t chunk_buf[MAX_FILE_SIZE];
+static uint8_t ref_buf[MAX_FILE_SIZE];
+static uint8_t str_a[STRING_SIZE];
+static uint8_t str_b[STRING_SIZE];
+static uint8_t str_c[STRING_SIZE];
+static char line[KEY_BUFFER_SIZE];
+static host_dentry_t dentry;
+static char name[FILE_NAME_LEN + 1];
+static uint32_t position;
+static uint32_t sink_used, sink_limit;
+static uint64_t samples[BENCH_RUNS];
+
+static const char *fsdir;
+
+/*
+ * now_ns
+ * description: the monotonic clock in ns
+ * input: none
+ * output: none
+ */
+static uint64_t now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * bench_report
+ * description: print min/median/max of the samples in ns, the same
+ * report launch_benchmarks gives in cycles
+ * input: what -- what was timed
+ * output: one line on stdout
+ */
+static void bench_report(const char *what)
+{
+	qsort(samples, BENCH_RUNS, sizeof(samples[0]), compare_samples);
+	printf("[BENCH %s] min = %llu median = %llu max = %llu ns\n", what,
+		(unsigned long long)samples[0],
+		(unsigned long long)samples[BENCH_RUNS / 2],
+		(unsigned long long)samples[BENCH_RUNS - 1]);
+}
+
+/*
+ * load_reference
+ * description: read the copy of a file from fsdir, the image cuts names
+ * at 32 characters so a longer name in fsdir matches on its start
+ * input: file -- the name in the image
+ * output: the file in ref_buf
+ * return: its length, -1 if there is no copy
+ */
+static int32_t load_reference(const char *file)
+{
+	char path[PATH_SIZE];
+	DIR *dir;
+	struct dirent *entry;
+	FILE *f = NULL;
+	size_t len;
+
+	if ((dir = opendir(fsdir)) == NULL) return -1;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (strncmp(entry->d_name, file, FILE_NAME_LEN) != 0) continue;
+		if (snprintf(path, sizeof(path), "%s/%s", fsdir, entry->d_name) >= PATH_SIZE) continue;
+		f = fopen(path, "rb");
+		break;
+	}
+	closedir(dir);
+	if (f == NULL) return -1;
+
+	len = fread(ref_buf, 1, MAX_FILE_SIZE, f);
+	fclose(f);
+	return (int32_t)len;
+}
+
+/*
+ * test_files
+ * description: every regular file reads back whole the same as its copy
+ * in fsdir, and is found again by its name
+ * input: none
+ * output: none
+ */
+static int test_files()
+{
+	uint32_t i, checked = 0;
+	int32_t len, ref_len;
+
+	for (i = 0; k_read_dentry_by_index(i, &dentry) == 0; i++)
+	{
+		if (dentry.file_type != TYPE_FILE) continue;
+		memcpy(name, dentry.file_name, FILE_NAME_LEN);
+		name[FILE_NAME_LEN] = '\0';
+
+		len = k_read_data(dentry.inodes, 0, file_buf, MAX_FILE_SIZE);
+		if (len != (int32_t)k_get_length(dentry.inodes))
+		{
+			printf("%s: read %d of %u bytes\n", name, len, k_get_length(dentry.inodes));
+			return FAIL;
+		}
+		if ((ref_len = load_reference(name)) >= 0)
+		{
+			if (ref_len != len || memcmp(ref_buf, file_buf, len) != 0)
+			{
+				printf("%s: differs from %s/%s\n", name, fsdir, name);
+				return FAIL;
+			}
+			checked++;
+		}
+		if (k_read_dentry_by_name((uint8_t *)name, &dentry) != 0)
+		{
+			printf("%s: not found by name\n", name);
+			return FAIL;
+		}
+	}
+	printf("%u files match %s\n", checked, fsdir);
+	return checked > 0 ? PASS : FAIL;
+}
+
+/*
+ * test_dirents
+ * description: read_dirents packs every directory entry once, in order,
+ * with the name, type, inode and length read_dentry_by_index gives, over
+ * as many calls as the buffer needs
+ * input: none
+ * output: none
+ */
+static int test_dirents()
+{
+	uint32_t index = 0, used, len;
+	int32_t ret;
+	host_dirent_t *record;
+
+	position = 0;
+	while ((ret = k_read_dirents(&position, chunk_buf, DIRENT_BUF_SIZE)) > 0)
+	{
+		for (used = 0; used < (uint32_t)ret; used += record->reclen)
+		{
+			record = (host_dirent_t *)(chunk_buf + used);
+			if (k_read_dentry_by_index(index++, &dentry) != 0) return FAIL;
+			len = strnlen((char *)dentry.file_name, FILE_NAME_LEN);
+			if (record->reclen % DIRENT_ALIGN != 0 || record->namelen != len ||
+				memcmp(record->name, dentry.file_name, len) != 0 || record->name[len] != '\0' ||
+				record->type != dentry.file_type || record->inode != dentry.inodes)
+			{
+				printf("dirent %u does not match its dentry\n", index - 1);
+				return FAIL;
+			}
+			if (dentry.file_type == TYPE_FILE && record->length != k_get_length(dentry.inodes))
+				return FAIL;
+		}
+	}
+	// the end is 0 and rewinds, and a buffer too small for one entry fails
+	if (ret != 0 || position != 0 || k_read_dentry_by_index(index, &dentry) == 0)
+		return FAIL;
+	if (k_read_dirents(&position, chunk_buf, sizeof(host_dirent_t)) != -1)
+		return FAIL;
+	return PASS;
+}
+
+/*
+ * host_sink
+ * description: the write function send_data gets, appends to chunk_buf
+ * and takes no more than sink_limit bytes in all
+ * input: fd -- not used
+ *        buf, nbytes -- what send_data hands over
+ * output: the bytes taken
+ */
+static int32_t host_sink(int32_t fd, const void *buf, int32_t nbytes)
+{
+	if ((uint32_t)nbytes > sink_limit - sink_used)
+		nbytes = sink_limit - sink_used;
+	memcpy(chunk_buf + sink_used, buf, nbytes);
+	sink_used += nbytes;
+	return nbytes;
+}
+
+/*
+ * fuzz_send_data
+ * description: send_data hands over the same bytes read_data reads, cut
+ * at the end of the file and where the writer stops taking them
+ * input: none
+ * output: none
+ */
+static int fuzz_send_data()
+{
+	uint32_t round, count = 0, offset, length, size, expect;
+	int32_t ret;
+
+	while (k_read_dentry_by_index(count, &dentry) == 0) count++;
+	if (count == 0) return FAIL;
+
+	for (round = 0; round < FUZZ_ROUNDS / 10; round++)
+	{
+		k_read_dentry_by_index(rand() % count, &dentry);
+		if (dentry.file_type != TYPE_FILE) continue;
+		size = k_get_length(dentry.inodes);
+		k_read_data(dentry.inodes, 0, file_buf, MAX_FILE_SIZE);
+
+		offset = rand() % (size + BLOCKS_SIZE);
+		length = rand() % (3 * BLOCKS_SIZE + 2);
+		sink_used = 0;
+		sink_limit = rand() % 4 == 0 ? rand() % (length + 1) : MAX_FILE_SIZE;
+		expect = offset >= size ? 0 : (length < size - offset ? length : size - offset);
+		if (expect > sink_limit) expect = sink_limit;
+
+		ret = k_send_data(dentry.inodes, offset, length, (int32_t (*)())host_sink, 1);
+		if (expect == 0 && offset < size && length != 0 ? ret != -1 : ret != (int32_t)expect)
+		{
+			printf("send_data(inode %u, offset %u, length %u) = %d, expected %u\n",
+				dentry.inodes, offset, length, ret, expect);
+			return FAIL;
+		}
+		if (sink_used != expect || memcmp(chunk_buf, file_buf + offset, expect) != 0)
+			return FAIL;
+	}
+	return PASS;
+}
+
+/*
+ * fuzz_read_data
+ * description: reads at random offsets and lengths return the bytes of
+ * the whole file at that offset, cut at the end of the file
+ * input: none
+ * output: none
+ */
+static int fuzz_read_data()
+{
+	uint32_t round, count = 0, offset, length, size, expect;
+	int32_t ret;
+
+	while (k_read_dentry_by_index(count, &dentry) == 0) count++;
+	if (count == 0) return FAIL;
+
+	for (round = 0; round < FUZZ_ROUNDS / 10; round++)
+	{
+		k_read_dentry_by_index(rand() % count, &dentry);
+		if (dentry.file_type != TYPE_FILE) continue;
+		size = k_get_length(dentry.inodes);
+		k_read_data(dentry.inodes, 0, file_buf, MAX_FILE_SIZE);
+
+		offset = rand() % (size + BLOCKS_SIZE);
+		length = rand() % (3 * BLOCKS_SIZE + 2);
+		expect = offset >= size ? 0 : (length < size - offset ? length : size - offset);
+		memset(chunk_buf, 0xA5, expect + 1);
+		ret = k_read_data(dentry.inodes, offset, chunk_buf, length);
+		if (ret != (int32_t)expect || memcmp(chunk_buf, file_buf + offset, expect) != 0 ||
+			chunk_buf[expect] != 0xA5)
+		{
+			printf("read_data(inode %u, offset %u, length %u) = %d, expected %u\n",
+				dentry.inodes, offset, length, ret, expect);
+			return FAIL;
+		}
+	}
+	if (k_read_data(0xFFFFFFFF, 0, chunk_buf, 1) != -1)
+		return FAIL;
+	return PASS;
+}
+
+/*
+ * fuzz_strings
+ * description: memcpy, memmove, memset, strncmp and strlen agree with
+ * libc on random data, lengths and alignments
+ * input: none
+ * output: none
+ */
+static int fuzz_strings()
+{
+	uint32_t round, i, n, a, b;
+	int32_t k, want;
+
+	for (round = 0; round < FUZZ_ROUNDS; round++)
+	{
+		n = rand() % STRING_MAX_LEN;
+		a = rand() % 4;
+		b = rand() % 4;
+		for (i = 0; i < STRING_SIZE; i++)
+			str_a[i] = rand() % 4 == 0 ? 0 : rand();
+		memset(str_b, 0, STRING_SIZE);
+
+		k_memcpy(str_b + b, str_a + a, n);
+		if (memcmp(str_b + b, str_a + a, n) != 0) return FAIL;
+
+		// overlapping both ways
+		memcpy(str_c, str_a, STRING_SIZE);
+		memmove(str_c + b, str_c + a, n);
+		k_memmove(str_a + b, str_a + a, n);
+		if (memcmp(str_a, str_c, STRING_SIZE) != 0) return FAIL;
+
+		k_memset(str_b + a, b, n);
+		for (i = 0; i < n; i++)
+			if (str_b[a + i] != b) return FAIL;
+
+		str_a[STRING_SIZE - 1] = '\0';
+		if (k_strlen((char *)str_a + a) != strlen((char *)str_a + a)) return FAIL;
+
+		memcpy(str_c, str_a, STRING_SIZE);
+		if (n != 0) str_c[rand() % n] ^= rand() % 2;
+		k = k_strncmp((char *)str_a, (char *)str_c, n);
+		want = strncmp((char *)str_a, (char *)str_c, n);
+		if ((k < 0) != (want < 0) || (k > 0) != (want > 0)) return FAIL;
+	}
+	return PASS;
+}
+
+/*
+ * fuzz_keyboard
+ * description: random scancodes never push the line past the buffer,
+ * never leave a hole in it and never move the cursor off the screen
+ * input: none
+ * output: none
+ */
+static int fuzz_keyboard()
+{
+	uint32_t round, i;
+	int ptr;
+	char *buffer = k_get_keyboard_buffer();
+	uint8_t key;
+
+	for (round = 0; round < FUZZ_ROUNDS; round++)
+	{
+		// mostly keys of the main block, pressed and released
+		switch (rand() % 8)
+		{
+		case 0:
+			key = rand();
+			break;
+		case 1:
+			key = SCANCODE_ENTER;
+			break;
+		case 2:
+			key = SCANCODE_BACKSPACE;
+			break;
+		default:
+			key = SCANCODE_FIRST_KEY + rand() % (SCANCODE_LAST_KEY - SCANCODE_FIRST_KEY + 1);
+			if (rand() % 2) key |= SCANCODE_RELEASE;
+		}
+		k_keyboard_scancode(key);
+
+		ptr = k_get_buffer_ptr();
+		if (ptr < 0 || ptr >= KEY_BUFFER_SIZE) return FAIL;
+		if ((int)k_strlen(buffer) != ptr) return FAIL;
+		for (i = ptr; i < KEY_BUFFER_SIZE; i++)
+			if (buffer[i] != '\0') return FAIL;
+		if (k_get_x() < 0 || k_get_x() >= NUM_COLS || k_get_y() < 0 || k_get_y() >= NUM_ROWS)
+			return FAIL;
+
+		// a reader takes the line now and then
+		if (rand() % 4 == 0 && k_host_take_line(line, KEY_BUFFER_SIZE) >= KEY_BUFFER_SIZE)
+			return FAIL;
+	}
+	return PASS;
+}
+
+/*
+ * run_benchmarks
+ * description: time what launch_benchmarks times in the kernel, minus the
+ * parts that need the hardware
+ * input: none
+ * output: a line per benchmark on stdout
+ */
+static void run_benchmarks()
+{
+	int32_t i;
+	uint32_t big_inode;
+	uint64_t start;
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		start = now_ns();
+		k_read_dentry_by_name((uint8_t *)BENCH_FILE, &dentry);
+		samples[i] = now_ns() - start;
+	}
+	bench_report("read_dentry_by_name");
+
+	if (k_read_dentry_by_name((uint8_t *)BENCH_BIG_FILE, &dentry) == 0)
+	{
+		big_inode = dentry.inodes;
+		for (i = 0; i < BENCH_RUNS; i++)
+		{
+			start = now_ns();
+			k_read_data(big_inode, 0, file_buf, MAX_FILE_SIZE);
+			samples[i] = now_ns() - start;
+		}
+		bench_report("read_data " BENCH_BIG_FILE);
+	}
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		start = now_ns();
+		k_memcpy(chunk_buf, file_buf, BENCH_COPY_SIZE);
+		samples[i] = now_ns() - start;
+	}
+	bench_report("memcpy 4KB");
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		start = now_ns();
+		memcpy(chunk_buf, file_buf, BENCH_COPY_SIZE);
+		samples[i] = now_ns() - start;
+	}
+	bench_report("libc memcpy 4KB");
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		k_set_x(0);
+		k_set_y(0);
+		start = now_ns();
+		k_putc('a');
+		samples[i] = now_ns() - start;
+	}
+	bench_report("putc");
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		start = now_ns();
+		k_scroll();
+		samples[i] = now_ns() - start;
+	}
+	bench_report("scroll");
+
+	for (i = 0; i < BENCH_RUNS; i++)
+	{
+		start = now_ns();
+		k_keyboard_scancode(SCANCODE_FIRST_KEY);
+		k_keyboard_scancode(SCANCODE_BACKSPACE);
+		samples[i] = now_ns() - start;
+	}
+	bench_report("keyboard key and backspace");
+}
+
+int main(int argc, char *argv[])
+{
+	int fd, failed = 0, result;
+	struct stat st;
+	void *image;
+
+	if (argc < 3)
+	{
+		fprintf(stderr, "usage: %s <filesys_img> <fsdir> [seed]\n", argv[0]);
+		return 2;
+	}
+	fsdir = argv[2];
+	srand(argc > 3 ? atoi(argv[3]) : 391);
+
+	// the image must be addressable with 32 bits, like the module GRUB loads
+	if ((fd = open(argv[1], O_RDONLY)) == -1 || fstat(fd, &st) == -1)
+	{
+		perror(argv[1]);
+		return 2;
+	}
+	image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_32BIT, fd, 0);
+	if (image == MAP_FAILED)
+	{
+		perror("mmap");
+		return 2;
+	}
+	close(fd);
+	module.mod_start = (uint32_t)(uintptr_t)image;
+	module.mod_end = module.mod_start + st.st_size;
+	k_init_file_system(&module);
+	k_set_video_mem((uint32_t)(uintptr_t)video);
+	k_clear();
+
+	result = test_files();
+	TEST_OUTPUT("files match fsdir", result);
+	failed |= !result;
+	result = test_dirents();
+	TEST_OUTPUT("dirents match dentries", result);
+	failed |= !result;
+	result = fuzz_read_data();
+	TEST_OUTPUT("read_data fuzz", result);
+	failed |= !result;
+	result = fuzz_send_data();
+	TEST_OUTPUT("send_data fuzz", result);
+	failed |= !result;
+	result = fuzz_strings();
+	TEST_OUTPUT("string fuzz", result);
+	failed |= !result;
+	result = fuzz_keyboard();
+	TEST_OUTPUT("keyboard fuzz", result);
+	failed |= !result;
+
+	run_benchmarks();
+
+	return failed;
+}
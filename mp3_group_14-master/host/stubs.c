@@ -0,0 +1,145 @@
+/* stubs.c - The rest of the kernel, as far as file_system.c, lib.c,
+ * spinlock.c and keyboard.c need it in the host harness. Built with the
+ * kernel headers, so everything here ends up with the k_ prefix as well.
+ */
+
+#include "types.h"
+#include "lib.h"
+#include "pcb.h"
+#include "schedule.h"
+#include "keyboard.h"
+#include "i8259.h"
+#include "cursor.h"
+#include "signal.h"
+#include "trace.h"
+#include "clock.h"
+#include "serial.h"
+#include "kthread.h"
+#include "workqueue.h"
+
+// the only process, file_read and dir_read find their descriptors here
+static pcb_t host_pcb;
+
+// signals the line discipline sent, e.g. on ctrl+c
+uint32_t host_signals_sent = 0;
+
+/*
+ * get_pcb
+ *   DESCRIPTION: the pcb of the harness
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: pointer to the pcb
+ *   SIDE EFFECTS: none
+ */
+pcb_t *get_pcb()
+{
+  return &host_pcb;
+}
+
+/* one screen, no scheduler, no interrupts and nothing to signal */
+
+int32_t get_current_running_terminal()
+{
+  return current_running_terminal;
+}
+
+int32_t get_current_looking_terminal()
+{
+  return current_looking_terminal;
+}
+
+void switch_screen(uint32_t next_terminal_id)
+{
+  current_looking_terminal = next_terminal_id;
+}
+
+void idle_wait()
+{
+}
+
+void wake_terminal(uint32_t t_id)
+{
+}
+
+void send_eoi(uint32_t irq_num)
+{
+}
+
+void update_cursor(int x, int y)
+{
+}
+
+void trace_dump()
+{
+}
+
+void exec_stats_dump()
+{
+}
+
+int32_t kthread_current()
+{
+  return KTHREAD_NONE;
+}
+
+/* no worker threads, the work runs at once */
+int32_t queue_work(work_t *work)
+{
+  work->func(work);
+  return 0;
+}
+
+void send_signal(uint32_t pid, int32_t signum)
+{
+  host_signals_sent++;
+}
+
+int32_t signal_kill_pending()
+{
+  return 0;
+}
+
+/* no TSC clock, the lock hold times stay 0 */
+
+uint64_t rdtsc()
+{
+  return 0;
+}
+
+uint32_t clock_tsc_khz()
+{
+  return 0;
+}
+
+uint64_t div64_32(uint64_t n, uint32_t d, uint32_t *rem)
+{
+  if (rem != NULL) *rem = n % d;
+  return n / d;
+}
+
+void serial_puts_polled(const int8_t *s)
+{
+}
+
+/*
+ * host_take_line
+ *   DESCRIPTION: what terminal_read does once enter was pressed, which
+ *                can not be called here since it first waits for enter
+ *   INPUTS: int8_t *buf -- where to copy the line
+ *           int32_t nbytes -- size of buf
+ *   OUTPUTS: none
+ *   RETURN VALUE: -1 if there is no line yet, else the length of the line
+ *   SIDE EFFECTS: the keyboard buffer is emptied
+ */
+int32_t host_take_line(int8_t *buf, int32_t nbytes)
+{
+  if (terminals[current_looking_terminal].enter_flag != HIGH)
+    return -1;
+  terminals[current_looking_terminal].enter_flag = LOW;
+  if (nbytes > KEY_BUFFER_SIZE)
+    nbytes = KEY_BUFFER_SIZE;
+  strncpy(buf, keyboard_buffer, nbytes);
+  memset(keyboard_buffer, '\0', KEY_BUFFER_SIZE);
+  set_buffer_ptr(0);
+  return strlen(buf);
+}
@@ -0,0 +1,89 @@
+#include "account.h"
+#include "lib.h"
+#include "pcb.h"
+
+/*
+ * account_tick
+ *   DESCRIPTION: called by pit_handler for a PIT tick that found a
+ *                process running rather than waiting, charges it the tick
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void account_tick()
+{
+  get_pcb()->acct.ticks++;
+}
+
+/*
+ * account_switch
+ *   DESCRIPTION: called by pit_handler when it switches to the process of
+ *                another terminal
+ *   INPUTS: uint32_t pid -- the process switched to
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void account_switch(uint32_t pid)
+{
+  get_pcb_by_pid(pid)->acct.switches++;
+}
+
+/*
+ * account_syscall
+ *   DESCRIPTION: called by syscall_linker on every valid system call
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void account_syscall()
+{
+  get_pcb()->acct.syscalls++;
+}
+
+/*
+ * account_page_fault
+ *   DESCRIPTION: called by page_fault for every fault, handled or not
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void account_page_fault()
+{
+  get_pcb()->acct.page_faults++;
+}
+
+/*
+ * account_read
+ *   DESCRIPTION: copy the accounting of the running processes, in pid
+ *                order. The counters of one process may be a tick apart
+ *                from those of the next, they are not copied atomically
+ *   INPUTS: uint32_t count -- room in buf, in entries
+ *   OUTPUTS: proc_stat_t *buf -- one entry per process
+ *   RETURN VALUE: the entries copied, -1 for a bad buffer
+ *   SIDE EFFECTS: none
+ */
+int32_t account_read(proc_stat_t *buf, uint32_t count)
+{
+  uint32_t pid, used = 0;
+  pcb_t *pcb;
+
+  if (buf == NULL) return -1;
+
+  for (pid = 0; pid < MAX_PROCESS_NUM && used < count; pid++)
+  {
+    if (process[pid] != PROCESS_ON) continue;
+    pcb = get_pcb_by_pid(pid);
+    buf[used].pid = pcb->pid;
+    buf[used].parent_pid = pcb->parent_pid;
+    buf[used].terminal_id = pcb->terminal_id;
+    buf[used].acct = pcb->acct;
+    strncpy(buf[used].name, pcb->name, ACCOUNT_NAME_LEN);
+    buf[used].name[ACCOUNT_NAME_LEN] = '\0';
+    used++;
+  }
+  return used;
+}
@@ -0,0 +1,36 @@
+#ifndef ACCOUNT_H
+#define ACCOUNT_H
+
+#include "types.h"
+
+// the longest program name, as in pcb.h
+#define ACCOUNT_NAME_LEN    32
+
+/* what a process has used so far, kept in its pcb */
+typedef struct proc_account {
+  uint32_t ticks;         /* PIT ticks that found it running */
+  uint32_t switches;      /* times the scheduler switched to it */
+  uint32_t syscalls;      /* system calls made */
+  uint32_t page_faults;   /* page faults taken, stack growth included */
+} proc_account_t;
+
+/* what the procstat system call copies out for one process */
+typedef struct proc_stat {
+  uint32_t pid;
+  uint32_t parent_pid;
+  uint32_t terminal_id;
+  proc_account_t acct;
+  int8_t name[ACCOUNT_NAME_LEN + 1];
+} proc_stat_t;
+
+void account_tick();
+
+void account_switch(uint32_t pid);
+
+void account_syscall();
+
+void account_page_fault();
+
+int32_t account_read(proc_stat_t *buf, uint32_t count);
+
+#endif
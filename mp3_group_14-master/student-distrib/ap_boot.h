@@ -0,0 +1,9 @@
+/* ap_boot.h - Header for the application processor trampoline */
+#include "smp.h"
+
+
+/* The real mode code copied to AP_TRAMPOLINE_ADDR, and the GDT pointer in
+ * it that is filled in with the copy. */
+extern uint8_t ap_trampoline[];
+extern uint8_t ap_gdt_desc[];
+extern uint8_t ap_trampoline_end[];
@@ -0,0 +1,241 @@
+#include "clock.h"
+#include "pit.h"
+
+// TSC cycles per millisecond, and the TSC at the end of calibration
+static uint32_t tsc_khz = 0;
+static uint64_t tsc_boot = 0;
+
+// one timer per process, since a process sleeps in only one place
+static sleep_timer_t timers[MAX_PROCESS_NUM];
+static sleep_timer_t *timer_head = NULL;
+
+/*
+ * rdtsc
+ *   DESCRIPTION: read the time stamp counter
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: the cycles since reset
+ *   SIDE EFFECTS: none
+ */
+uint64_t rdtsc()
+{
+  uint64_t tsc;
+  asm volatile("rdtsc" : "=A"(tsc));
+  return tsc;
+}
+
+/*
+ * div64_32
+ *   DESCRIPTION: divide a 64 bit number by a 32 bit one with two divl, the
+ *                kernel does not link libgcc for 64 bit division
+ *   INPUTS: uint64_t n -- the dividend
+ *           uint32_t d -- the divisor, not 0
+ *           uint32_t *rem -- where to store the remainder, may be NULL
+ *   OUTPUTS: none
+ *   RETURN VALUE: the quotient
+ *   SIDE EFFECTS: none
+ */
+uint64_t div64_32(uint64_t n, uint32_t d, uint32_t *rem)
+{
+  uint32_t high = (uint32_t)(n >> 32);
+  uint32_t low = (uint32_t)n;
+  uint32_t q_high, q_low, r;
+
+  // the high half first, its remainder keeps the second divl from overflowing
+  q_high = high / d;
+  high %= d;
+  asm("divl %4" : "=a"(q_low), "=d"(r) : "a"(low), "d"(high), "rm"(d));
+  if (rem != NULL) *rem = r;
+  return ((uint64_t)q_high << 32) | q_low;
+}
+
+/*
+ * clock_init
+ *   DESCRIPTION: calibrate the TSC against a 10ms one-shot of PIT channel 2,
+ *                which is free since channel 0 drives the scheduler
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the monotonic clock starts at 0 here
+ */
+void clock_init()
+{
+  uint32_t flags;
+  uint8_t gate;
+  uint64_t start, end;
+
+  cli_and_save(flags);
+
+  // gate channel 2 on with the speaker off
+  gate = inb(SPEAKER_PORT);
+  outb((gate & ~SPEAKER_DATA) | SPEAKER_GATE, SPEAKER_PORT);
+
+  // mode 0, the output goes high when the count runs out
+  outb(MODE_0_CHANNEL_2, PIT_COMMAND);
+  outb(CALIBRATE_CLOCKS & BYTE_MASK, CHANNEL_2);
+  outb(CALIBRATE_CLOCKS >> BYTE_SHIFT, CHANNEL_2);
+
+  start = rdtsc();
+  while (!(inb(SPEAKER_PORT) & SPEAKER_OUT));
+  end = rdtsc();
+
+  outb(gate, SPEAKER_PORT);
+  tsc_khz = (uint32_t)div64_32(end - start, CALIBRATE_MS, NULL);
+  if (tsc_khz == 0) tsc_khz = 1;
+  tsc_boot = end;
+
+  restore_flags(flags);
+}
+
+/*
+ * clock_tsc_khz
+ *   DESCRIPTION: the calibrated TSC rate
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: TSC cycles per millisecond
+ *   SIDE EFFECTS: none
+ */
+uint32_t clock_tsc_khz()
+{
+  return tsc_khz;
+}
+
+/*
+ * clock_tsc_boot
+ *   DESCRIPTION: the TSC the monotonic clock counts from
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: the TSC at the end of calibration, 0 before it
+ *   SIDE EFFECTS: none
+ */
+uint64_t clock_tsc_boot()
+{
+  return tsc_boot;
+}
+
+/*
+ * clock_ns
+ *   DESCRIPTION: the monotonic clock
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: nanoseconds since clock_init, 0 before it
+ *   SIDE EFFECTS: none
+ */
+uint64_t clock_ns()
+{
+  uint32_t rem;
+  uint64_t ms;
+
+  if (tsc_khz == 0) return 0;
+  // whole milliseconds, then the remainder, so nothing overflows
+  ms = div64_32(rdtsc() - tsc_boot, tsc_khz, &rem);
+  return ms * NS_PER_MS + div64_32((uint64_t)rem * NS_PER_MS, tsc_khz, NULL);
+}
+
+/*
+ * timer_add
+ *   DESCRIPTION: arm the sleep timer of a process
+ *   INPUTS: uint32_t pid -- the sleeping process
+ *           uint64_t deadline -- clock_ns() value to wake up at
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void timer_add(uint32_t pid, uint64_t deadline)
+{
+  uint32_t flags;
+  sleep_timer_t **pos;
+  sleep_timer_t *timer = &timers[pid];
+
+  cli_and_save(flags);
+  timer->deadline = deadline;
+  timer->pid = pid;
+  timer->expired = 0;
+
+  // keep the list sorted, the earliest deadline first
+  for (pos = &timer_head; *pos != NULL && (*pos)->deadline <= deadline; pos = &(*pos)->next);
+  timer->next = *pos;
+  *pos = timer;
+  restore_flags(flags);
+}
+
+/*
+ * timer_cancel
+ *   DESCRIPTION: disarm the sleep timer of a process if it is armed
+ *   INPUTS: uint32_t pid -- the process
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void timer_cancel(uint32_t pid)
+{
+  uint32_t flags;
+  sleep_timer_t **pos;
+
+  cli_and_save(flags);
+  for (pos = &timer_head; *pos != NULL; pos = &(*pos)->next)
+  {
+    if (*pos == &timers[pid])
+    {
+      *pos = timers[pid].next;
+      break;
+    }
+  }
+  restore_flags(flags);
+}
+
+/*
+ * timer_expired
+ *   DESCRIPTION: check whether the sleep timer of a process has fired
+ *   INPUTS: uint32_t pid -- the process
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if it fired, 0 otherwise
+ *   SIDE EFFECTS: none
+ */
+int32_t timer_expired(uint32_t pid)
+{
+  return timers[pid].expired;
+}
+
+/*
+ * timer_expire
+ *   DESCRIPTION: called on every PIT interrupt, fire the timers whose
+ *                deadline has passed and wake their processes
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void timer_expire()
+{
+  uint64_t now = clock_ns();
+
+  while (timer_head != NULL && timer_head->deadline <= now)
+  {
+    timer_head->expired = 1;
+    wake_terminal(get_pcb_by_pid(timer_head->pid)->terminal_id);
+    timer_head = timer_head->next;
+  }
+}
+
+/*
+ * timer_clocks_left
+ *   DESCRIPTION: the next deadline of the sleep timers, for tickless idle
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: PIT clocks until the earliest timer, PIT_MAX_COUNT when
+ *                 there is none or it is further than a one-shot can wait
+ *   SIDE EFFECTS: none
+ */
+uint32_t timer_clocks_left()
+{
+  uint64_t now, left;
+
+  if (timer_head == NULL) return PIT_MAX_COUNT;
+  now = clock_ns();
+  if (timer_head->deadline <= now) return 1;
+  left = timer_head->deadline - now;
+  if (left > MAX_ONESHOT_NS) return PIT_MAX_COUNT;
+  // round up so the one-shot does not fire just before the deadline
+  return (uint32_t)div64_32(left * PIT_CLOCK_HZ, NS_PER_SEC, NULL) + 1;
+}
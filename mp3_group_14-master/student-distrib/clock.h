@@ -0,0 +1,62 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "types.h"
+
+// PIT channel 2 is gated through the speaker port for calibration
+#define SPEAKER_PORT        0x61
+#define SPEAKER_GATE        0x01
+#define SPEAKER_DATA        0x02
+#define SPEAKER_OUT         0x20
+#define CHANNEL_2           0x42
+#define MODE_0_CHANNEL_2    0xB0
+
+// calibrate over 10ms of PIT clocks
+#define CALIBRATE_MS        10
+#define CALIBRATE_CLOCKS    (PIT_CLOCK_HZ / 1000 * CALIBRATE_MS)
+#define PIT_CLOCK_HZ        1193180
+
+#define NS_PER_MS           1000000
+#define NS_PER_SEC          1000000000
+#define MS_PER_SEC          1000
+
+// a one-shot never has to wait longer than this many ns
+#define MAX_ONESHOT_NS      55000000
+
+/* the time format of clock_gettime and nanosleep */
+typedef struct timespec {
+  uint32_t tv_sec;
+  uint32_t tv_nsec;
+} timespec_t;
+
+/* a process sleeping in nanosleep, kept in a list sorted by deadline */
+typedef struct sleep_timer {
+  uint64_t deadline;
+  uint32_t pid;
+  volatile uint32_t expired;
+  struct sleep_timer *next;
+} sleep_timer_t;
+
+void clock_init();
+
+uint64_t rdtsc();
+
+uint64_t div64_32(uint64_t n, uint32_t d, uint32_t *rem);
+
+uint64_t clock_ns();
+
+uint32_t clock_tsc_khz();
+
+uint64_t clock_tsc_boot();
+
+void timer_add(uint32_t pid, uint64_t deadline);
+
+void timer_cancel(uint32_t pid);
+
+int32_t timer_expired(uint32_t pid);
+
+void timer_expire();
+
+uint32_t timer_clocks_left();
+
+#endif
@@ -2,12 +2,14 @@
 
 /* function pointers for file, directory and rtc and the elf format */
 uint8_t elf[] = {0x7f, 0x45, 0x4c, 0x46};
-func_ptr file_funcs[FUNCTION_PTR_SIZE] = {file_read, file_write, file_open, file_close};
-func_ptr dir_funcs[FUNCTION_PTR_SIZE] = {dir_read, dir_write, dir_open, dir_close};
-func_ptr rtc_funcs[FUNCTION_PTR_SIZE] = {rtc_read, rtc_write, rtc_open, rtc_close};
+func_ptr file_funcs[FUNCTION_PTR_SIZE] = {file_read, file_write, file_open, file_close, file_poll};
+func_ptr dir_funcs[FUNCTION_PTR_SIZE] = {dir_read, dir_write, dir_open, dir_close, dir_poll};
+func_ptr rtc_funcs[FUNCTION_PTR_SIZE] = {rtc_read, rtc_write, rtc_open, rtc_close, rtc_poll};
+func_ptr serial_funcs[FUNCTION_PTR_SIZE] = {serial_read, serial_write, serial_open, serial_close, serial_poll};
 
 //An array that stores the process status
 int32_t process[MAX_PROCESS_NUM] = {PROCESS_OFF, PROCESS_OFF, PROCESS_OFF, PROCESS_OFF, PROCESS_OFF, PROCESS_OFF};
+static spinlock_t process_lock = SPINLOCK_INIT("process");
 
 static int8_t args[NAME_BUFFER];
 
@@ -21,16 +23,33 @@ static int8_t args[NAME_BUFFER];
  */
 extern int32_t get_next_pid(){
   int i;
+  uint32_t flags = spin_lock_irqsave(&process_lock);
   // loop over the array and return the next available
   for(i = 0; i < MAX_PROCESS_NUM; i++){
     if(process[i] == PROCESS_OFF){
       process[i] = PROCESS_ON;
+      spin_unlock_irqrestore(&process_lock, flags);
       return i;
     }
   }
+  spin_unlock_irqrestore(&process_lock, flags);
   return -1;
 }
 
+/*
+ * put_pid
+ *   DESCRIPTION: give back a pid get_next_pid handed out
+ *   INPUTS: int32_t pid -- the pid
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+extern void put_pid(int32_t pid){
+  uint32_t flags = spin_lock_irqsave(&process_lock);
+  process[pid] = PROCESS_OFF;
+  spin_unlock_irqrestore(&process_lock, flags);
+}
+
 /*
  * halt
  *   DESCRIPTION: halt the current process
@@ -41,14 +60,34 @@ extern int32_t get_next_pid(){
  */
 extern int32_t halt(uint8_t status)
 {
-  // todo : chekpoint 3
+  return halt_process((uint32_t)status & SB_MASK);
+}
 
+/*
+ * halt_process
+ *   DESCRIPTION: tear down the current process and return to the execute
+ *                call of its parent
+ *   INPUTS: uint32_t status -- the value execute returns to the parent,
+ *                              HALT_BY_SIGNAL when killed by a signal
+ *   OUTPUTS: none
+ *   RETURN VALUE: never returns
+ *   SIDE EFFECTS: none
+ */
+extern int32_t halt_process(uint32_t status)
+{
   // pop kernel stack of process
   // pop page for process
   // close files used by process
   // return control
   int32_t i, esp, ebp;
   pcb_t *current_pcb = get_pcb();
+
+  // a thread made by clone leaves the address space to its program
+  if (current_pcb->tgid != current_pcb->pid) thread_exit(status);
+
+  // a switch while the pages go away would resume in the torn down space
+  preempt_disable();
+
   for (i = 0; i < MAX_FILE; i++)
   {
     if (current_pcb->descriptors[i].f_flag == INUSE)
@@ -57,23 +96,34 @@ extern int32_t halt(uint8_t status)
     }
   }
 
-  // reset the process flag
-  process[current_pcb->pid] = PROCESS_OFF;
+  // the threads of the process go with its address space
+  thread_group_kill(current_pcb->pid);
+
+  // reset the process flag, the zeroer clears the program frame
+  put_pid(current_pcb->pid);
+  prezero_release(current_pcb->pid);
+
+  // drop the file mappings, the heap, the stack and the io rings of the process
+  delete_mmap_page(current_pcb->pid);
+  delete_user_data_pages(current_pcb->pid);
+  ring_release(current_pcb->pid);
+  timer_cancel(current_pcb->pid);
 
   // if try to halt the first three, relaunch
   uint8_t jb[] = "shell";
   if (current_pcb -> pid == PROCESS_ZERO || current_pcb -> pid == PROCESS_ONE || current_pcb -> pid == PROCESS_TWO) {
+    preempt_enable();
     execute(jb);
   }
   
-  // reset the current terminal vid_mem flag
-  if (terminals[current_running_terminal].user_vid_mem == HIGH){
-    terminals[current_running_terminal].user_vid_mem = LOW;
-    delete_user_video_page();
+  // reset the process vid_mem flag
+  if (current_pcb->vid_mapped == HIGH){
+    current_pcb->vid_mapped = LOW;
+    delete_user_video_page(current_pcb->pid);
   }
 
-  // reset the paing back to the parent process
-  reset_paging(_8MB + _4MB * (current_pcb->parent_pid));
+  // switch back to the address space of the parent process
+  load_page_directory(get_pcb_by_pid(current_pcb->parent_pid)->page_directory);
 
   // reset tss to parent process
   tss.esp0 = current_pcb->parent_esp0;
@@ -84,7 +134,11 @@ extern int32_t halt(uint8_t status)
   ebp = current_pcb->parent_ebp;
   current_pcb = (pcb_t *)(PCB_BASE + (MAX_PCB - current_pcb->parent_pid) * _8KB);
   int32_t sb = (int32_t)status;
-  sb &= SB_MASK;
+
+  // until the stack is the parent's, get_pcb still names the child. The
+  // parent's execute puts the interrupt flag back
+  cli();
+  preempt_enable();
   asm volatile(
       "movl %0, %%esp \n \
        movl %1, %%ebp \n \
@@ -93,7 +147,6 @@ extern int32_t halt(uint8_t status)
         :
         : "r"(esp), "r"(ebp), "r"(sb)
         : "eax", "esp", "ebp");
-  status = (uint8_t)sb;
 
   return 0;
 }
@@ -108,12 +161,19 @@ extern int32_t halt(uint8_t status)
  */
 extern int32_t execute(const uint8_t *command)
 {
-  int32_t flags;
-  cli_and_save(flags);
   int32_t next_pid;
+  uint64_t start = rdtsc();
+
+  // interrupts stay on during the load, but a switch to another terminal
+  // would resume this one in the address space of the caller, and args is
+  // shared
+  preempt_disable();
 
   // sanity check
-  if((next_pid = get_next_pid()) == -1) return -1;
+  if((next_pid = get_next_pid()) == -1) {
+    preempt_enable();
+    return -1;
+  }
 
   int i, j, k;
   int32_t test;
@@ -121,7 +181,8 @@ extern int32_t execute(const uint8_t *command)
   dentry_t dentry;
   uint8_t realname[NAME_BUFFER];
   uint32_t physical_addr;
-  uint8_t sanity_buffer[FUNCTION_PTR_SIZE];
+  uint32_t *page_directory;
+  uint8_t sanity_buffer[ELF_MAGIC_SIZE];
   uint32_t *buffer;
   uint32_t *user_stack;
 
@@ -148,7 +209,8 @@ extern int32_t execute(const uint8_t *command)
 
   //check file validity
   if (read_dentry_by_name(realname, &dentry) == -1) {
-    process[next_pid] = LOW;
+    put_pid(next_pid);
+    preempt_enable();
     return -1; // if read fails
   }
 
@@ -157,7 +219,8 @@ extern int32_t execute(const uint8_t *command)
 
   // check if executable
   if (strncmp((int8_t *)sanity_buffer, (int8_t *)elf, sizeof(sanity_buffer) != SET_ZERO)){
-    process[next_pid] = LOW;
+    put_pid(next_pid);
+    preempt_enable();
     return -1; // if string compare fails
   }
 
@@ -167,24 +230,45 @@ extern int32_t execute(const uint8_t *command)
   //assign value for the entry point
   entry = *((uint32_t *)sanity_buffer);
 
-  //setup paging
+  //setup paging, the new process gets its own page directory
   physical_addr = _8MB + _4MB * next_pid;
-  reset_paging(physical_addr);
+  page_directory = init_process_paging(next_pid, physical_addr);
+  vdso_map(next_pid, get_current_running_terminal());
+
+  // the first stack page is mapped now, the rest grows on demand
+  if (map_user_data_page(next_pid, USER_STACK_TOP - _4KB) == -1) {
+    put_pid(next_pid);
+    preempt_enable();
+    return -1;
+  }
+  // the frame must not show the program what the last one left in it
+  prezero_claim(next_pid);
+  load_page_directory(page_directory);
 
   //load the program to the page;
   buffer = (uint32_t *)(_128MB + PROGRAM_OFFSET);
-  user_stack = (uint32_t *)(_128MB + _4MB);
+  user_stack = (uint32_t *)USER_STACK_TOP;
   test = read_data(dentry.inodes, SET_ZERO, (uint8_t *)buffer, _4MB);
 
   //configuring pcb
   pcb_t *pcb = (pcb_t *)(PCB_BASE + (MAX_PCB - next_pid) * _8KB);
   pcb_init(pcb, next_pid);
+  strncpy(pcb->name, (int8_t *)realname, PROCESS_NAME_LEN);
+  pcb->name[PROCESS_NAME_LEN] = '\0';
+  pcb->page_directory = page_directory;
+  pcb->heap_break = USER_HEAP_ADDR;
+  pcb->stack_bottom = USER_STACK_TOP - _4KB;
 
   // set the tss for the process
   pcb->parent_esp0 = tss.esp0;
   tss.esp0 = (uint32_t)(PCB_BASE + (MAX_PCB - next_pid) * _8KB + _8KB - PCB_OFFSET);
   tss.ss0 = KERNEL_DS;
 
+  // the iret turns interrupts back on, with the child's stack in place
+  cli();
+  exec_latency_record(rdtsc() - start);
+  preempt_enable();
+
   //context switch
   // PUSH ORDER:
   // USER_DS
@@ -213,8 +297,6 @@ extern int32_t execute(const uint8_t *command)
       : "r"(entry), "r"(USER_CS), "r"(user_stack), "r"(USER_DS)
       : "memory", "esp", "ebp");
 
-  restore_flags(flags);
-
   return 0;
 }
 
@@ -223,46 +305,12 @@ extern int32_t execute(const uint8_t *command)
  *   DESCRIPTION: terminate the programs
  *   INPUTS: none
  *   OUTPUTS: none
- *   RETURN VALUE: 0 for success
- *   SIDE EFFECTS: squash the programs if exception happens
+ *   RETURN VALUE: never returns
+ *   SIDE EFFECTS: squash the program, its parent sees status 256
  */
 extern int32_t terminate_by_exception()
 {
-  uint32_t i, esp, ebp;
-
-  // reset paing
-  pcb_t *current_pcb = get_pcb();
-  reset_paging(_4MB + _4MB * (current_pcb->parent_pid));
-
-  // set the process flag
-  process[current_pcb->pid] = LOW;
-
-  //close files in the pcb
-  for (i = 0; i < MAX_FILE; i++)
-  {
-    if (current_pcb->descriptors[i].f_flag == INUSE)
-    {
-      // 3 call close and 0 pass in anything
-      current_pcb->descriptors[i].file_operations_table_ptr[3](0); 
-    }
-  }
-
-  // reset tss to parent 
-  tss.esp0 = current_pcb->parent_esp0;
-
-  // update current pcb, child space discarded
-  current_pcb = (pcb_t *)(PCB_BASE + (MAX_PCB - current_pcb->parent_pid) * _8KB);
-
-  /*error code not get, put -1 in eax*/
-  asm volatile(
-        "movl %0, %%esp \n\
-         movl %1, %%ebp \n\
-         movl $-1, %%eax \n\
-         jmp return_from_child"
-          :
-          : "r"(esp), "r"(ebp)
-          : "eax", "esp", "ebp");
-  return 0;
+  return halt_process(HALT_BY_SIGNAL);
 }
 
 /*
@@ -292,6 +340,20 @@ extern int32_t open(const uint8_t *filename)
   }
 
   if (i == MAX_FILE) return -1;
+
+  // the serial port is a device, it has no entry in the file system
+  if (strncmp((int8_t *)filename, (int8_t *)SERIAL_DEVICE_NAME, sizeof(SERIAL_DEVICE_NAME)) == 0)
+  {
+    fd = &(current_pcb->descriptors[i]);
+    fd->file_operations_table_ptr = serial_funcs;
+    fd->f_inode = NULL;
+    fd->f_file_position = SET_ZERO;
+    fd->f_flag = INUSE;
+    fd->f_status = 0;
+    serial_open(filename);
+    return i;
+  }
+
   // check if the file name is valid
 
   if (read_dentry_by_name(filename, &dentry) == -1) return -1; // if read name fails
@@ -307,6 +369,7 @@ extern int32_t open(const uint8_t *filename)
     fd->f_inode = inode;
     fd->f_file_position = SET_ZERO;
     fd->f_flag = INUSE;
+    fd->f_status = 0;
   }
   if (dentry.file_type == TYPE_FILE)
   {
@@ -314,13 +377,16 @@ extern int32_t open(const uint8_t *filename)
     fd->f_inode = inode;
     fd->f_file_position = SET_ZERO;
     fd->f_flag = INUSE;
+    fd->f_status = 0;
   }
   if (dentry.file_type == TYPE_RTC)
   {
     fd->file_operations_table_ptr = rtc_funcs;
     fd->f_inode = inode;
-    fd->f_file_position = SET_ZERO;
+    // the position is the rtc tick last read, interrupts before open do not count
+    fd->f_file_position = rtc_ticks;
     fd->f_flag = INUSE;
+    fd->f_status = 0;
   }
   return i;
 }
@@ -417,38 +483,599 @@ extern int32_t vidmap(uint8_t **screen_start)
   // senity check
   if (screen_start == NULL) return -1;
 
-  terminals[get_current_running_terminal()].user_vid_mem = HIGH;
   // check the validity of screen start and map the video memory
-  if(screen_start >= (uint8_t **)_128MB && screen_start < (uint8_t **)(_128MB + _4MB)){
-      reset_video_page(VID_MEM_ADDR);
+  if(user_range_valid(screen_start, sizeof(uint8_t *))){
+      pcb_t *current_pcb = get_mm_pcb();
+      current_pcb->vid_mapped = HIGH;
+      // a process whose terminal is not shown draws into the terminal buffer
+      if (current_pcb->terminal_id == get_current_looking_terminal()) {
+        reset_video_page(current_pcb->pid, VID_MEM_ADDR);
+      } else {
+        reset_video_page(current_pcb->pid, VID_MEM_BUFFER1 + _4KB * current_pcb->terminal_id);
+      }
       *screen_start = (uint8_t *)USER_VID_MEM;
       return 0;
   }
   return -1;
 }
 
+/*
+ * mmap
+ *   DESCRIPTION: map the data blocks of an opened file read-only into the
+ *                user mmap region, page by page, without copying them
+ *   INPUTS: int32_t fd -- the opened regular file
+ *           uint32_t length -- how many bytes of the file to map
+ *           uint8_t **map_start -- where to store the start of the mapping
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 for success, -1 for failure
+ *   SIDE EFFECTS: flush the TLB
+ */
+extern int32_t mmap(int32_t fd, uint32_t length, uint8_t **map_start)
+{
+  uint32_t i, num_pages;
+  uint32_t *block;
+  inode_t *inode;
+  pcb_t *current_pcb = get_pcb();
+  pcb_t *mm_pcb = get_mm_pcb();
+
+  // sanity check
+  if (fd < SKIP_INOUT || fd >= MAX_FILE || length == 0 || map_start == NULL) return -1;
+  if (!user_range_valid(map_start, sizeof(uint8_t *))) return -1;
+  if (current_pcb->descriptors[fd].f_flag == UNUSE) return -1;
+
+  // only regular files have data blocks to map
+  if (current_pcb->descriptors[fd].file_operations_table_ptr != file_funcs) return -1;
+
+  inode = (inode_t *)current_pcb->descriptors[fd].f_inode;
+  if (length > inode->length) length = inode->length;
+  if (length == 0) return -1;
+
+  // check there is enough room left in the mmap region
+  num_pages = (length + _4KB - 1) / _4KB;
+  if (mm_pcb->mmap_pages + num_pages > PTE_SIZE) return -1;
+
+  // data blocks are shared with the module, so they must be page aligned
+  for (i = 0; i < num_pages; i++)
+  {
+    block = get_data_block(inode, i);
+    if (block == NULL || ((uint32_t)block & ~PHYS_MASK) != 0) {
+      // undo the pages set so far
+      while (i-- > 0) set_mmap_pte(mm_pcb->pid, mm_pcb->mmap_pages + i, 0);
+      return -1;
+    }
+    set_mmap_pte(mm_pcb->pid, mm_pcb->mmap_pages + i, (uint32_t)block);
+  }
+  flush_tlb();
+
+  *map_start = (uint8_t *)(USER_MMAP_ADDR + mm_pcb->mmap_pages * _4KB);
+  mm_pcb->mmap_pages += num_pages;
+  return 0;
+}
+
+/*
+ * sbrk
+ *   DESCRIPTION: move the end of the heap of the current process, pages
+ *                are mapped or freed as the break crosses page boundaries
+ *   INPUTS: int32_t increment -- how many bytes to add, may be negative
+ *   OUTPUTS: none
+ *   RETURN VALUE: the old break for success, -1 for failure
+ *   SIDE EFFECTS: flush the TLB
+ */
+extern int32_t sbrk(int32_t increment)
+{
+  uint32_t page, old_break, new_break;
+  pcb_t *current_pcb = get_mm_pcb();
+
+  old_break = current_pcb->heap_break;
+  new_break = old_break + increment;
+
+  // the heap cannot shrink below its start
+  if (increment < 0 && (uint32_t)(-increment) > old_break - USER_HEAP_ADDR) return -1;
+  // keep one guard page between the heap and the stack
+  if (increment > 0 && PAGE_ROUND_UP(new_break) > current_pcb->stack_bottom - _4KB) return -1;
+
+  if (increment > 0)
+  {
+    for (page = PAGE_ROUND_UP(old_break); page < new_break; page += _4KB)
+    {
+      if (map_user_data_page(current_pcb->pid, page) == -1)
+      {
+        // undo the pages mapped so far
+        while (page > PAGE_ROUND_UP(old_break))
+        {
+          page -= _4KB;
+          unmap_user_data_page(current_pcb->pid, page);
+        }
+        return -1;
+      }
+    }
+  }
+  else
+  {
+    for (page = PAGE_ROUND_UP(new_break); page < PAGE_ROUND_UP(old_break); page += _4KB)
+      unmap_user_data_page(current_pcb->pid, page);
+  }
+
+  current_pcb->heap_break = new_break;
+  return old_break;
+}
+
+/*
+ * clock_gettime
+ *   DESCRIPTION: read the monotonic clock, backed by the calibrated TSC
+ *   INPUTS: timespec_t *ts -- where to store the time since boot
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 for success, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t clock_gettime(timespec_t *ts)
+{
+  uint32_t nsec;
+  uint64_t now;
+
+  // sanity check
+  if (ts == NULL || !user_range_valid(ts, sizeof(timespec_t))) return -1;
+
+  now = clock_ns();
+  ts->tv_sec = (uint32_t)div64_32(now, NS_PER_SEC, &nsec);
+  ts->tv_nsec = nsec;
+  return 0;
+}
+
+/*
+ * nanosleep
+ *   DESCRIPTION: sleep for the given time without owning the RTC, the
+ *                process waits in hlt until its timer fires
+ *   INPUTS: const timespec_t *req -- how long to sleep
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 for success, -1 for failure or when a signal that
+ *                 kills the process cuts the sleep short
+ *   SIDE EFFECTS: none
+ */
+extern int32_t nanosleep(const timespec_t *req)
+{
+  uint32_t flags;
+  uint64_t deadline;
+  pcb_t *current_pcb = get_pcb();
+
+  // sanity check
+  if (req == NULL || !user_range_valid(req, sizeof(timespec_t))) return -1;
+  if (req->tv_nsec >= NS_PER_SEC) return -1;
+  if (req->tv_sec == 0 && req->tv_nsec == 0) return 0;
+
+  deadline = clock_ns() + (uint64_t)req->tv_sec * NS_PER_SEC + req->tv_nsec;
+
+  cli_and_save(flags);
+  timer_add(current_pcb->pid, deadline);
+  while (!timer_expired(current_pcb->pid))
+  {
+    if (signal_kill_pending())
+    {
+      timer_cancel(current_pcb->pid);
+      restore_flags(flags);
+      return -1;
+    }
+    idle_wait();
+  }
+  restore_flags(flags);
+  return 0;
+}
+
+/*
+ * profile
+ *   DESCRIPTION: control the PIT sampling profiler
+ *   INPUTS: int32_t cmd -- PROFILE_START, PROFILE_STOP or PROFILE_DUMP
+ *   OUTPUTS: the flat profile on COM1 for PROFILE_DUMP
+ *   RETURN VALUE: the number of samples taken, -1 for failure
+ *   SIDE EFFECTS: PROFILE_START clears the previous profile
+ */
+extern int32_t profile(int32_t cmd)
+{
+  return profile_command(cmd);
+}
+
+/*
+ * irqstat
+ *   DESCRIPTION: get the latency statistics of an interrupt line
+ *   INPUTS: uint32_t irq -- the irq line
+ *           irq_stat_t *buf -- where to copy them, NULL to clear them
+ *   OUTPUTS: the statistics in buf
+ *   RETURN VALUE: 0 for success, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t irqstat(uint32_t irq, irq_stat_t *buf)
+{
+  // sanity check
+  if (irq >= LATENCY_IRQS) return -1;
+  if (buf == NULL)
+  {
+    irq_latency_reset(irq);
+    return 0;
+  }
+  if (!user_range_valid(buf, sizeof(irq_stat_t))) return -1;
+
+  return irq_latency_read(irq, buf);
+}
+
+/*
+ * poll
+ *   DESCRIPTION: wait until one of several descriptors is ready, asking
+ *                each one through the poll entry of its jump table. The
+ *                process sleeps in hlt in between, every event source
+ *                wakes it while poll_waiters is set
+ *   INPUTS: pollfd_t *fds -- the descriptors and the events wanted, a
+ *                            negative fd is skipped
+ *           uint32_t nfds -- how many, at most MAX_FILE
+ *           int32_t timeout_ms -- how long to wait, 0 to not wait and
+ *                                 negative to wait with no limit
+ *   OUTPUTS: the events that happened in the revents of every entry
+ *   RETURN VALUE: the number of entries with revents set, 0 on timeout,
+ *                 -1 for failure or when a signal that kills the process
+ *                 cuts the wait short
+ *   SIDE EFFECTS: none
+ */
+extern int32_t poll(pollfd_t *fds, uint32_t nfds, int32_t timeout_ms)
+{
+  uint32_t i, flags;
+  int32_t ready, fd;
+  pollfd_t kfds[MAX_FILE];
+  pcb_t *current_pcb = get_pcb();
+
+  // sanity check
+  if (nfds == 0 || nfds > MAX_FILE || fds == NULL) return -1;
+  if (!user_range_valid(fds, nfds * sizeof(pollfd_t))) return -1;
+  memcpy(kfds, fds, nfds * sizeof(pollfd_t));
+
+  if (timeout_ms > 0)
+    timer_add(current_pcb->pid, clock_ns() + (uint64_t)timeout_ms * NS_PER_MS);
+
+  cli_and_save(flags);
+  poll_waiters++;
+  while (1)
+  {
+    ready = 0;
+    for (i = 0; i < nfds; i++)
+    {
+      fd = kfds[i].fd;
+      kfds[i].revents = 0;
+      if (fd < 0) continue;
+      if (fd >= MAX_FILE || current_pcb->descriptors[fd].f_flag == UNUSE)
+        kfds[i].revents = POLLNVAL;
+      else
+        kfds[i].revents = current_pcb->descriptors[fd].file_operations_table_ptr[POLL_FUNC](fd) & kfds[i].events;
+      if (kfds[i].revents != 0) ready++;
+    }
+    if (ready != 0 || timeout_ms == 0) break;
+    if (timeout_ms > 0 && timer_expired(current_pcb->pid)) break;
+    if (signal_kill_pending())
+    {
+      ready = -1;
+      break;
+    }
+    idle_wait();
+  }
+  poll_waiters--;
+  restore_flags(flags);
+
+  // an expired timer is already off the list
+  if (timeout_ms > 0) timer_cancel(current_pcb->pid);
+  if (ready == -1) return -1;
+
+  for (i = 0; i < nfds; i++)
+    fds[i].revents = kfds[i].revents;
+  return ready;
+}
+
+/*
+ * fcntl
+ *   DESCRIPTION: get or set the status flags of an open descriptor, so far
+ *                only O_NONBLOCK, which makes the terminal, rtc and serial
+ *                reads return -EAGAIN instead of waiting
+ *   INPUTS: int32_t fd -- the descriptor
+ *           uint32_t cmd -- F_GETFL or F_SETFL
+ *           uint32_t arg -- the new flags for F_SETFL
+ *   OUTPUTS: none
+ *   RETURN VALUE: the flags for F_GETFL, 0 for F_SETFL, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t fcntl(int32_t fd, uint32_t cmd, uint32_t arg)
+{
+  pcb_t *current_pcb = get_pcb();
+
+  // sanity check
+  if (fd < 0 || fd >= MAX_FILE || current_pcb->descriptors[fd].f_flag == UNUSE) return -1;
+
+  switch (cmd)
+  {
+  case F_GETFL:
+    return current_pcb->descriptors[fd].f_status;
+  case F_SETFL:
+    if (arg & ~O_SETTABLE) return -1;
+    current_pcb->descriptors[fd].f_status = arg;
+    return 0;
+  default:
+    return -1;
+  }
+}
+
+/*
+ * ring_setup
+ *   DESCRIPTION: map a submission and a completion ring into the current
+ *                process, so it can queue reads and writes in memory and
+ *                run a batch of them with one ring_enter
+ *   INPUTS: void
+ *   OUTPUTS: none
+ *   RETURN VALUE: the user address of the io_ring_t, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t ring_setup(void)
+{
+  return ring_create(get_mm_pcb()->pid);
+}
+
+/*
+ * ring_enter
+ *   DESCRIPTION: run the submissions queued in the ring of the current
+ *                process and post their completions
+ *   INPUTS: uint32_t to_submit -- the most submissions to run
+ *   OUTPUTS: the completions in the completion ring
+ *   RETURN VALUE: the number of submissions run, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t ring_enter(uint32_t to_submit)
+{
+  return ring_drain(get_mm_pcb()->pid, to_submit);
+}
+
+/*
+ * getdents
+ *   DESCRIPTION: read many entries of an opened directory at once, packed
+ *                as dirent_t records with their type, inode and length
+ *   INPUTS: int32_t fd -- the opened directory
+ *           void *buf -- where to pack the records
+ *           int32_t nbytes -- the size of buf
+ *   OUTPUTS: the records in buf
+ *   RETURN VALUE: the bytes packed, 0 at the end of the directory, -1 for
+ *                 failure or a buffer too small for the next entry
+ *   SIDE EFFECTS: moves the position dir_read also uses
+ */
+extern int32_t getdents(int32_t fd, void *buf, int32_t nbytes)
+{
+  pcb_t *current_pcb = get_pcb();
+
+  // sanity check
+  if (fd < 0 || fd >= MAX_FILE || buf == NULL || nbytes <= 0) return -1;
+  if (current_pcb->descriptors[fd].f_flag == UNUSE) return -1;
+  if (current_pcb->descriptors[fd].file_operations_table_ptr != dir_funcs) return -1;
+  if (!user_range_valid(buf, nbytes)) return -1;
+
+  return read_dirents(&current_pcb->descriptors[fd].f_file_position, buf, nbytes);
+}
+
+/*
+ * sendfile
+ *   DESCRIPTION: write the next bytes of a regular file to another
+ *                descriptor inside the kernel, the data goes from the file
+ *                system image to the output without a user buffer
+ *   INPUTS: int32_t out_fd -- where to write, e.g. stdout
+ *           int32_t in_fd -- the opened regular file
+ *           int32_t count -- the most bytes to send
+ *   OUTPUTS: none
+ *   RETURN VALUE: the bytes sent, 0 at the end of the file, -1 for failure
+ *   SIDE EFFECTS: advances the position of in_fd by the bytes sent
+ */
+extern int32_t sendfile(int32_t out_fd, int32_t in_fd, int32_t count)
+{
+  int32_t sent;
+  uint32_t inode;
+  fd_t *in, *out;
+  pcb_t *current_pcb = get_pcb();
+
+  // sanity check
+  if (out_fd < 0 || out_fd >= MAX_FILE || in_fd < 0 || in_fd >= MAX_FILE || count < 0) return -1;
+  in = &current_pcb->descriptors[in_fd];
+  out = &current_pcb->descriptors[out_fd];
+  if (in->f_flag == UNUSE || out->f_flag == UNUSE) return -1;
+  if (in->file_operations_table_ptr != file_funcs) return -1;
+  if (count == 0) return 0;
+
+  inode = ((uint32_t)in->f_inode - (uint32_t)inodes_start) / BLOCKS_SIZE;
+  sent = send_data(inode, in->f_file_position, count, out->file_operations_table_ptr[1], out_fd);
+  if (sent > 0) in->f_file_position += sent;
+  return sent;
+}
+
+/*
+ * procstat
+ *   DESCRIPTION: copy out the cpu ticks, switches, system calls and page
+ *                faults of every running process, for top
+ *   INPUTS: proc_stat_t *buf -- room for count entries
+ *           uint32_t count -- the most entries to copy
+ *   OUTPUTS: one entry per process in buf, in pid order
+ *   RETURN VALUE: the entries copied, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t procstat(proc_stat_t *buf, uint32_t count)
+{
+  // sanity check
+  if (count == 0) return 0;
+  if (count > MAX_PROCESS_NUM) count = MAX_PROCESS_NUM;
+  if (!user_range_valid(buf, count * sizeof(proc_stat_t))) return -1;
+
+  return account_read(buf, count);
+}
+
+/*
+ * clone
+ *   DESCRIPTION: start a thread of the current program. It shares the page
+ *                directory, so the heap, the mmap region, vidmap and the io
+ *                rings, but has its own kernel stack, descriptors (stdin and
+ *                stdout to begin with) and pid. It takes turns with the
+ *                other threads at the slot of the terminal
+ *   INPUTS: void *entry -- where the thread starts in user space
+ *           void *stack -- the top of its stack, in the heap of the program
+ *           uint32_t *tid_addr -- set to the pid of the thread, cleared with
+ *                                 a futex_wake when it halts, may be NULL
+ *   OUTPUTS: none
+ *   RETURN VALUE: the pid of the thread, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t clone(void *entry, void *stack, uint32_t *tid_addr)
+{
+  // sanity check
+  if (!user_ptr_valid(entry) || !user_ptr_valid((uint8_t *)stack - 1)) return -1;
+  if (tid_addr != NULL && (((uint32_t)tid_addr & (sizeof(uint32_t) - 1)) || !user_ptr_valid(tid_addr))) return -1;
+
+  return thread_create(entry, stack, tid_addr);
+}
+
+/*
+ * futex_wait
+ *   DESCRIPTION: sleep until a futex_wake on a word of the program, if it
+ *                still holds the value the caller saw. The check and the
+ *                sleep are one step, so a mutex or a condition variable can
+ *                be built on top without losing a wakeup
+ *   INPUTS: uint32_t *addr -- the word, aligned
+ *           uint32_t val -- the value the caller saw in it
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 when woken, -EAGAIN if the word changed, -1 for failure
+ *                 or a signal
+ *   SIDE EFFECTS: none
+ */
+extern int32_t futex_wait(uint32_t *addr, uint32_t val)
+{
+  // sanity check
+  if (((uint32_t)addr & (sizeof(uint32_t) - 1)) || !user_ptr_valid(addr)) return -1;
+
+  return futex_sleep(addr, val);
+}
+
+/*
+ * futex_wake
+ *   DESCRIPTION: wake threads of the program sleeping on a word
+ *   INPUTS: uint32_t *addr -- the word
+ *           uint32_t count -- the most threads to wake
+ *   OUTPUTS: none
+ *   RETURN VALUE: the threads woken, -1 for failure
+ *   SIDE EFFECTS: none
+ */
+extern int32_t futex_wake(uint32_t *addr, uint32_t count)
+{
+  // sanity check
+  if (((uint32_t)addr & (sizeof(uint32_t) - 1)) || !user_ptr_valid(addr)) return -1;
+
+  return futex_wakeup(addr, count);
+}
+
+/*
+ * user_ptr_valid
+ *   DESCRIPTION: check that a pointer passed in by the user points into
+ *                memory of the current process that is mapped
+ *   INPUTS: const void *ptr -- the pointer to check
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if the pointer is valid, 0 otherwise
+ *   SIDE EFFECTS: may grow the user stack down to ptr
+ */
+extern int32_t user_ptr_valid(const void *ptr)
+{
+  uint32_t addr = (uint32_t)ptr;
+  pcb_t *current_pcb = get_mm_pcb();
+
+  // the program page
+  if (addr >= _128MB && addr < _128MB + _4MB) return 1;
+  // the heap
+  if (addr >= USER_HEAP_ADDR && addr < current_pcb->heap_break) return 1;
+  // the stack, exec maps one page of it and the rest comes on demand
+  if (addr < current_pcb->stack_bottom) grow_user_stack(addr);
+  if (addr >= current_pcb->stack_bottom && addr < USER_STACK_TOP) return 1;
+  return 0;
+}
+
+/*
+ * user_range_valid
+ *   DESCRIPTION: check that a buffer passed in by the user lies whole in
+ *                one mapped region of the current process. The regions
+ *                have unmapped pages between them, so checking the two
+ *                ends of a buffer is not enough
+ *   INPUTS: const void *ptr -- the start of the buffer
+ *           uint32_t len -- its length in bytes
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if the buffer is valid, 0 otherwise
+ *   SIDE EFFECTS: may grow the user stack down to the buffer
+ */
+extern int32_t user_range_valid(const void *ptr, uint32_t len)
+{
+  uint32_t start = (uint32_t)ptr;
+  uint32_t end = start + len;
+  pcb_t *current_pcb = get_mm_pcb();
+
+  // a buffer wrapping around the top of memory
+  if (end < start) return 0;
+  if (len == 0) return user_ptr_valid(ptr);
+
+  // the program page
+  if (start >= _128MB && end <= _128MB + _4MB) return 1;
+  // the heap
+  if (start >= USER_HEAP_ADDR && end <= current_pcb->heap_break) return 1;
+  // the stack, grown down to a buffer the program has not touched yet
+  if (start < current_pcb->stack_bottom && end <= USER_STACK_TOP) grow_user_stack(start);
+  if (start >= current_pcb->stack_bottom && end <= USER_STACK_TOP) return 1;
+  return 0;
+}
+
 /*
  * set_handler
- *   DESCRIPTION: extra for this mp
- *   INPUTS: int32_t signum, void *handler_address
+ *   DESCRIPTION: set the user handler of a signal for the current process
+ *   INPUTS: int32_t signum -- the signal
+ *           void *handler_address -- the handler, NULL for the default action
  *   OUTPUTS: none
- *   RETURN VALUE: -1
+ *   RETURN VALUE: 0 for success, -1 for failure
  *   SIDE EFFECTS: none
  */
 extern int32_t set_handler(int32_t signum, void *handler_address)
 {
-  return -1;
+  pcb_t *current_pcb = get_pcb();
+
+  // sanity check
+  if (signum < 0 || signum >= NUM_SIGNALS) return -1;
+  if (handler_address != NULL && !user_ptr_valid(handler_address)) return -1;
+
+  current_pcb->sig_handlers[signum] = handler_address;
+  return 0;
 }
 
 /*
  * sig_return
- *   DESCRIPTION: extra for this mp
+ *   DESCRIPTION: called by the trampoline when a signal handler returns,
+ *                copy the registers saved by do_signal back into the frame
+ *                of this system call so iret resumes the interrupted code
  *   INPUTS: void
  *   OUTPUTS: none
- *   RETURN VALUE: -1
- *   SIDE EFFECTS: none
+ *   RETURN VALUE: the saved eax, so the linker leaves it in place
+ *   SIDE EFFECTS: unmask signals
  */
 extern int32_t sig_return(void)
 {
-  return -1;
+  pcb_t *current_pcb = get_pcb();
+  // the frame of this system call sits at the top of the kernel stack
+  hw_context_t *regs = (hw_context_t *)(tss.esp0 - sizeof(hw_context_t));
+  // the handler returned into the trampoline, so esp points at signum
+  hw_context_t *saved = (hw_context_t *)(regs->esp + sizeof(uint32_t));
+
+  // sanity check
+  if (!user_range_valid(saved, sizeof(hw_context_t))) return -1;
+
+  // segment registers stay those of the frame, the flags are filtered
+  regs->ebx = saved->ebx;
+  regs->ecx = saved->ecx;
+  regs->edx = saved->edx;
+  regs->esi = saved->esi;
+  regs->edi = saved->edi;
+  regs->ebp = saved->ebp;
+  regs->return_address = saved->return_address;
+  regs->esp = saved->esp;
+  regs->eflags = (regs->eflags & ~USER_EFLAGS_MASK) | (saved->eflags & USER_EFLAGS_MASK) | EFLAGS_IF;
+
+  current_pcb->sig_masked = 0;
+  return saved->eax;
 }
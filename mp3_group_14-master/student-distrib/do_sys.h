@@ -7,6 +7,18 @@
 #include "x86_desc.h"
 #include "lib.h"
 #include "paging.h"
+#include "clock.h"
+#include "schedule.h"
+#include "serial.h"
+#include "profile.h"
+#include "spinlock.h"
+#include "latency.h"
+#include "poll.h"
+#include "fcntl.h"
+#include "ring.h"
+#include "account.h"
+#include "prezero.h"
+#include "thread.h"
 
 //check for those numbers
 #define PCB_BASE 0x7F0000 + _8KB * 2
@@ -23,7 +35,8 @@
 #define _4MB            0x00400000
 #define _8KB            0x00002000
 #define _128MB          0x08000000
-#define FUNCTION_PTR_SIZE 4
+#define FUNCTION_PTR_SIZE 5
+#define ELF_MAGIC_SIZE  4
 #define SET_ZERO        0
 #define MAX_PCB         5
 #define MAX_FILE        8
@@ -49,12 +62,16 @@
 
 
 
+extern int32_t process[MAX_PROCESS_NUM];
+
 extern int32_t terminate_by_exception();
 
 extern int32_t execute(const uint8_t * command);
 
 extern int32_t halt(uint8_t status);
 
+extern int32_t halt_process(uint32_t status);
+
 extern int32_t read(int32_t fd, void * buf, int32_t nbytes);
 
 extern int32_t write(int32_t fd, const void * buf, int32_t nbytes);
@@ -67,10 +84,48 @@ extern int32_t getargs(int8_t * buf, int32_t nbytes);
 
 extern int32_t vidmap(uint8_t ** screen_start);
 
+extern int32_t mmap(int32_t fd, uint32_t length, uint8_t ** map_start);
+
+extern int32_t sbrk(int32_t increment);
+
+extern int32_t clock_gettime(timespec_t * ts);
+
+extern int32_t nanosleep(const timespec_t * req);
+
+extern int32_t profile(int32_t cmd);
+
+extern int32_t irqstat(uint32_t irq, irq_stat_t *buf);
+
+extern int32_t poll(pollfd_t *fds, uint32_t nfds, int32_t timeout_ms);
+
+extern int32_t fcntl(int32_t fd, uint32_t cmd, uint32_t arg);
+
+extern int32_t ring_setup(void);
+
+extern int32_t ring_enter(uint32_t to_submit);
+
+extern int32_t getdents(int32_t fd, void *buf, int32_t nbytes);
+
+extern int32_t sendfile(int32_t out_fd, int32_t in_fd, int32_t count);
+
+extern int32_t procstat(proc_stat_t *buf, uint32_t count);
+
+extern int32_t clone(void *entry, void *stack, uint32_t *tid_addr);
+
+extern int32_t futex_wait(uint32_t *addr, uint32_t val);
+
+extern int32_t futex_wake(uint32_t *addr, uint32_t count);
+
+extern int32_t user_ptr_valid(const void * ptr);
+
+extern int32_t user_range_valid(const void * ptr, uint32_t len);
+
 extern int32_t set_handler(int32_t signum, void * handler_address);
 
 extern int32_t sig_return(void);
 
 extern int32_t get_next_pid();
 
+extern void put_pid(int32_t pid);
+
 #endif
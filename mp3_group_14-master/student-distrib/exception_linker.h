@@ -0,0 +1,18 @@
+/* exception_linker.h - Header for the exception linkers */
+
+
+/* Pointer to assembly linker. */
+extern void page_fault_linker();
+extern void division_by_zero_linker();
+extern void over_flow_linker();
+extern void bound_range_exceeded_linker();
+extern void invalid_opcode_linker();
+extern void device_not_available_linker();
+extern void coprocessor_segment_overrun_linker();
+extern void invalid_TSS_linker();
+extern void segment_not_present_linker();
+extern void stack_segment_fault_linker();
+extern void general_protection_linker();
+extern void FPU_floating_point_error_linker();
+extern void alignment_check_linker();
+extern void SIMD_floating_point_exception_linker();
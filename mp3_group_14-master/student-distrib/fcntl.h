@@ -0,0 +1,17 @@
+#ifndef FCNTL_H
+#define FCNTL_H
+
+#include "types.h"
+
+// commands of the fcntl system call
+#define F_GETFL             3       /* return the status flags */
+#define F_SETFL             4       /* replace the status flags */
+
+// status flags of a descriptor, kept in f_status
+#define O_NONBLOCK          0x0800  /* a read that would wait fails instead */
+#define O_SETTABLE          O_NONBLOCK
+
+// what a read on an O_NONBLOCK descriptor returns, negated, when it would wait
+#define EAGAIN              11
+
+#endif
@@ -328,6 +328,19 @@ int32_t file_write(int32_t fd, const void *buf, int32_t length)
     return -1;
 }
 
+/*
+ * file_poll
+ *   DESCRIPTION: the poll entry of a regular file, which never blocks
+ *   INPUTS: int32_t fd -- not used
+ *   OUTPUTS: none
+ *   RETURN VALUE: POLLIN | POLLOUT
+ *   SIDE EFFECTS: none
+ */
+int32_t file_poll(int32_t fd)
+{
+    return POLLIN | POLLOUT;
+}
+
 /*
  * dir_open
  *   DESCRIPTION: open the corresponding dir
@@ -484,6 +497,160 @@ uint32_t get_length(uint32_t inodes)
     temp = (inode_t *)((uint32_t)fs_start + (inodes + 1) * BLOCKS_SIZE);
     return temp->length;
 }
+
+/*
+ * read_dirents
+ *   DESCRIPTION: pack as many directory entries as fit into a buffer, with
+ *                the type, inode and length of each, so a listing takes
+ *                one call instead of one read per name
+ *   INPUTS: uint32_t *position -- the next entry, advanced past the ones
+ *                                 packed and reset to 0 at the end
+ *           uint8_t *buf -- where to pack the dirent_t records
+ *           uint32_t length -- the size of buf
+ *   OUTPUTS: none
+ *   RETURN VALUE: the bytes packed, 0 once all entries are read
+ *                 -1 if not even the next entry fits
+ *   SIDE EFFECTS: none
+ */
+int32_t read_dirents(uint32_t *position, uint8_t *buf, uint32_t length)
+{
+    dentry_t *dentry;
+    dirent_t *record;
+    uint32_t used = 0, name_len, rec_len;
+
+    if (*position >= boot_block->num_dir_entries)
+    {
+        *position = 0;
+        return 0;
+    }
+
+    while (*position < boot_block->num_dir_entries)
+    {
+        dentry = &boot_block->dentries[*position];
+
+        // names of FILE_NAME_LEN bytes carry no NUL of their own
+        for (name_len = 0; name_len < FILE_NAME_LEN && dentry->file_name[name_len] != '\0'; name_len++);
+        rec_len = (sizeof(dirent_t) + name_len + 1 + DIRENT_ALIGN - 1) & ~(DIRENT_ALIGN - 1);
+        if (used + rec_len > length)
+            break;
+
+        record = (dirent_t *)(buf + used);
+        record->reclen = rec_len;
+        record->type = dentry->file_type;
+        record->namelen = name_len;
+        record->inode = dentry->inodes;
+        record->length = (dentry->file_type == TYPE_FILE) ? get_length(dentry->inodes) : 0;
+        memcpy(record->name, dentry->file_name, name_len);
+        record->name[name_len] = '\0';
+
+        used += rec_len;
+        (*position)++;
+    }
+
+    return (used == 0) ? -1 : (int32_t)used;
+}
+
+/*
+ * send_data
+ *   DESCRIPTION: hand the bytes of a file to a write function straight
+ *                from its data blocks in the file system image, a block at
+ *                a time, without copying them anywhere first
+ *   INPUTS: uint32_t inode -- the file
+ *           uint32_t offset -- where to start in the file
+ *           uint32_t length -- how many bytes to send
+ *           int32_t (*write)() -- the write entry of the output's jump table
+ *           int32_t out_fd -- the descriptor handed to write
+ *   OUTPUTS: none
+ *   RETURN VALUE: the bytes written, cut at the end of the file or where
+ *                 write took less than it was given
+ *                 -1 for failure before anything was written
+ *   SIDE EFFECTS: none
+ */
+int32_t send_data(uint32_t inode, uint32_t offset, uint32_t length, int32_t (*write)(), int32_t out_fd)
+{
+    inode_t *cur_node;
+    uint32_t *block;
+    uint32_t sent = 0, chunk, block_offset;
+    int32_t written;
+
+    if (write == NULL || inode >= boot_block->num_inodes)
+    {
+        return -1;
+    }
+    cur_node = (inode_t *)((uint32_t)inodes_start + inode * BLOCKS_SIZE);
+
+    if (offset >= cur_node->length)
+    {
+        return 0;
+    }
+    if (length > cur_node->length - offset)
+    {
+        length = cur_node->length - offset;
+    }
+
+    while (sent < length)
+    {
+        // a signal that kills the process ends a long send
+        if (sent != 0 && signal_kill_pending())
+        {
+            break;
+        }
+
+        block = get_data_block(cur_node, (offset + sent) / BLOCKS_SIZE);
+        if (block == NULL)
+        {
+            break;
+        }
+        block_offset = (offset + sent) % BLOCKS_SIZE;
+        chunk = BLOCKS_SIZE - block_offset;
+        if (chunk > length - sent)
+        {
+            chunk = length - sent;
+        }
+
+        written = write(out_fd, (uint8_t *)block + block_offset, (int32_t)chunk);
+        if (written <= 0)
+        {
+            break;
+        }
+        sent += written;
+        if ((uint32_t)written < chunk)
+        {
+            break;
+        }
+    }
+
+    return (sent == 0 && length != 0) ? -1 : (int32_t)sent;
+}
+
+/*
+ * get_data_block
+ *   DESCRIPTION: find the address of the index-th data block of a file
+ *   INPUTS: inode_t *inode -- the inode of the file
+ *           uint32_t index -- which block of the file, in file order
+ *   OUTPUTS: none
+ *   RETURN VALUE: the address of the data block in the file system image
+ *                 NULL for failure
+ *   SIDE EFFECTS: none
+ */
+uint32_t *get_data_block(inode_t *inode, uint32_t index)
+{
+    uint32_t cur_block_index;
+
+    // sanity check, the block must lie inside the file
+    if (inode == NULL || index >= BLOCKS_TOTAL_MINUS || index * BLOCKS_SIZE >= inode->length)
+    {
+        return NULL;
+    }
+
+    cur_block_index = inode->file_blocks[index];
+    if (cur_block_index >= boot_block->num_data_blocks)
+    {
+        return NULL;
+    }
+
+    return (uint32_t *)((uint32_t)data_blocks_start + cur_block_index * BLOCKS_SIZE);
+}
 /*
  * dir_write
  *   DESCRIPTION: no inplemented this checkpoint
@@ -497,3 +664,16 @@ int32_t dir_write(int32_t fd, const void *buf, int32_t length)
     // do nothing and return -1
     return -1;
 }
+
+/*
+ * dir_poll
+ *   DESCRIPTION: the poll entry of a directory, which never blocks
+ *   INPUTS: int32_t fd -- not used
+ *   OUTPUTS: none
+ *   RETURN VALUE: POLLIN | POLLOUT
+ *   SIDE EFFECTS: none
+ */
+int32_t dir_poll(int32_t fd)
+{
+    return POLLIN | POLLOUT;
+}
@@ -6,6 +6,7 @@
 #include "lib.h"
 #include "pcb.h"
 #include "do_sys.h"
+#include "poll.h"
 
 
 #define BOOT_BLOCK_RESERVED_TOTAL    52
@@ -21,6 +22,7 @@
 #define TYPE_RTC                     0
 #define TYPE_DIR                     1
 #define TYPE_FILE                    2
+#define DIRENT_ALIGN                 4
 
 
 
@@ -32,6 +34,18 @@ typedef struct dentry
     uint8_t dentry_reserved[DENTRY_RESERVED_TOTAL];
 } dentry_t;
 
+/* one record of getdents, the name is NUL terminated and the record is
+   padded so the next one starts DIRENT_ALIGN aligned */
+typedef struct dirent
+{
+    uint16_t reclen;
+    uint8_t type;
+    uint8_t namelen;
+    uint32_t inode;
+    uint32_t length;
+    uint8_t name[];
+} dirent_t;
+
 typedef struct inode
 {
     uint32_t length;
@@ -57,12 +71,17 @@ int32_t file_open(const uint8_t * filename);
 int32_t file_close(int32_t fd);
 int32_t file_read(int32_t fd, void *buf, int32_t length);
 int32_t file_write(int32_t fd, const void *buf, int32_t length);
+int32_t file_poll(int32_t fd);
 
 int32_t dir_open(const uint8_t * filename);
 int32_t dir_close(int32_t fd);
 int32_t dir_read(int32_t fd, void * buf, int32_t length);
 int32_t dir_write(int32_t fd, const void *buf, int32_t length);
+int32_t dir_poll(int32_t fd);
 uint32_t get_length(uint32_t inodes);
+int32_t read_dirents(uint32_t *position, uint8_t *buf, uint32_t length);
+int32_t send_data(uint32_t inode, uint32_t offset, uint32_t length, int32_t (*write)(), int32_t out_fd);
+uint32_t *get_data_block(inode_t *inode, uint32_t index);
 
 /* create local variables */
  uint32_t *fs_start;
@@ -4,6 +4,7 @@
 
 #include "i8259.h"
 #include "lib.h"
+#include "latency.h"
 
 /* Interrupt masks to determine which interrupts are enabled and disabled */
 uint8_t master_mask; /* IRQs 0-7  */
@@ -95,6 +96,9 @@ void disable_irq(uint32_t irq_num)
  */
 void send_eoi(uint32_t irq_num)
 {
+  // the handler is done, as far as interrupt latency goes
+  irq_latency_eoi(irq_num);
+
   if (irq_num >= TOTAL_IRQ_NUM)
   {
     irq_num -= TOTAL_IRQ_NUM;
@@ -31,7 +31,7 @@ void initialize_idt()
         if (i >= start_interrupt)
         {
             idt[i].reserved3 = ZERO;
-            SET_IDT_ENTRY(idt[i], general_protection);
+            SET_IDT_ENTRY(idt[i], unknown_interrupt);
         }
 
         // mark the DPL to 3 indicates a system call
@@ -43,55 +43,93 @@ void initialize_idt()
     }
 
     // set idt entries for the exceptions or interrupts
-    SET_IDT_ENTRY(idt[DIVISON_BY_ZERO], division_by_zero);
+    SET_IDT_ENTRY(idt[DIVISON_BY_ZERO], &division_by_zero_linker);
     SET_IDT_ENTRY(idt[SYSTEM_RESERVED], system_reserved);
     SET_IDT_ENTRY(idt[NON_MASKABLE_INTR], non_maskable_interrupt);
     SET_IDT_ENTRY(idt[BREAK_POINT], break_point);
-    SET_IDT_ENTRY(idt[OVER_FLOW], over_flow);
-    SET_IDT_ENTRY(idt[BOUND_RANGE_EXCEEDED], bound_range_exceeded);
-    SET_IDT_ENTRY(idt[INVALID_OPCODE], invalid_opcode);
-    SET_IDT_ENTRY(idt[DEVICE_NOT_AVAILABLE], device_not_available);
+    SET_IDT_ENTRY(idt[OVER_FLOW], &over_flow_linker);
+    SET_IDT_ENTRY(idt[BOUND_RANGE_EXCEEDED], &bound_range_exceeded_linker);
+    SET_IDT_ENTRY(idt[INVALID_OPCODE], &invalid_opcode_linker);
+    SET_IDT_ENTRY(idt[DEVICE_NOT_AVAILABLE], &device_not_available_linker);
     SET_IDT_ENTRY(idt[DOUBLE_FAULT], double_fault);
-    SET_IDT_ENTRY(idt[COPROCESSOR_SEGMENT_OVERRUN], coprocessor_segment_overrun);
-    SET_IDT_ENTRY(idt[INVALID_TSS], invalid_TSS);
-    SET_IDT_ENTRY(idt[SEGMENT_NOT_PRESENT], segment_not_present);
-    SET_IDT_ENTRY(idt[STACK_SEGMENT_FAULT], stack_segment_fault);
-    SET_IDT_ENTRY(idt[GENERAL_PROTECTION], general_protection);
-    SET_IDT_ENTRY(idt[PAGE_FAULT], page_fault);
+    SET_IDT_ENTRY(idt[COPROCESSOR_SEGMENT_OVERRUN], &coprocessor_segment_overrun_linker);
+    SET_IDT_ENTRY(idt[INVALID_TSS], &invalid_TSS_linker);
+    SET_IDT_ENTRY(idt[SEGMENT_NOT_PRESENT], &segment_not_present_linker);
+    SET_IDT_ENTRY(idt[STACK_SEGMENT_FAULT], &stack_segment_fault_linker);
+    SET_IDT_ENTRY(idt[GENERAL_PROTECTION], &general_protection_linker);
+    SET_IDT_ENTRY(idt[PAGE_FAULT], &page_fault_linker);
     SET_IDT_ENTRY(idt[RESERVED_EXCEPTION], reserved_exception);
-    SET_IDT_ENTRY(idt[FPU_FLOATING_POINT_ERROR], FPU_floating_point_error);
-    SET_IDT_ENTRY(idt[ALIGNMENT_CHECK], alignment_check);
+    SET_IDT_ENTRY(idt[FPU_FLOATING_POINT_ERROR], &FPU_floating_point_error_linker);
+    SET_IDT_ENTRY(idt[ALIGNMENT_CHECK], &alignment_check_linker);
     SET_IDT_ENTRY(idt[MACHINE_CHECK], machine_check);
-    SET_IDT_ENTRY(idt[SIMD_FLOATING_POINT_EXCEPTION], SIMD_floating_point_exception);
+    SET_IDT_ENTRY(idt[SIMD_FLOATING_POINT_EXCEPTION], &SIMD_floating_point_exception_linker);
 
     SET_IDT_ENTRY(idt[SYSTEM_CALL], &syscall_linker);
     SET_IDT_ENTRY(idt[KEYBOARD_LINKER], &keyboard_linker);
     SET_IDT_ENTRY(idt[RTC_LINKER], &rtc_linker);
     SET_IDT_ENTRY(idt[PIT_LINKER], &pit_linker);
+    SET_IDT_ENTRY(idt[SERIAL_LINKER], &serial_linker);
 }
 
 /*
- *  division_by_zero
+ * exception_signal
  * decription:
- * interrupt handler the deals with the given interrupt
+ * an exception taken in user mode becomes a signal on the current process,
+ * it is handled on the way back to user space. One taken in the kernel is
+ * a kernel bug
+ * input: regs -- the registers saved by the linker
+ *        signum -- the signal to raise
+ *        name -- what to print for a kernel exception
+ * output: none
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
+ */
+void exception_signal(hw_context_t *regs, int32_t signum, int8_t *name)
+{
+    if ((regs->cs & USER_RPL) == USER_RPL)
+    {
+        fault_signal(signum);
+        return;
+    }
+
+    cli();
+    clear();
+    printf("%s", name);
+    while (1)
+        ;
+}
+
+/*
+ * unknown_interrupt
+ * decription:
+ * handler for the vectors nothing is installed on
  * input: none
  * output: none
  * sideffect: print the interrupt type on screen and hold the control
  */
-void division_by_zero()
+void unknown_interrupt()
 {
     cli();
     clear();
-    // int8_t conv_buf[1];
-    // conv_buf[0] = 0;
-    // puts(conv_buf);
-    // puts("divide_by_zero_error_exception!\n");
-    printf("division by zero");
-    // terminate_by_exception();
+    printf("unknown interrupt");
     while (1)
         ;
 }
 
+/*
+ * division_by_zero
+ * decription:
+ * exception handler, raises DIV_ZERO on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
+ * output: none
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
+ */
+void division_by_zero(hw_context_t *regs)
+{
+    exception_signal(regs, DIV_ZERO, "division by zero");
+}
+
 /*
  * system_reserved
  * decription:
@@ -152,73 +190,57 @@ void break_point()
 /*
  * over_flow
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void over_flow()
+void over_flow(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("overflow!\n");
-    printf("overflow");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "overflow");
 }
 
 /*
  * bound_range_exceeded
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void bound_range_exceeded()
+void bound_range_exceeded(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("Exceed the range!\n");
-    printf("brx");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "brx");
 }
 
 /*
  * invalid_opcode
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void invalid_opcode()
+void invalid_opcode(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("Invalid opcode!\n");
-    printf("invalid");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "invalid");
 }
 
 /*
  * device_not_available
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void device_not_available()
+void device_not_available(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("device not available!\n");
-    printf("device_not_available");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "device_not_available");
 }
 
 /*
@@ -242,109 +264,92 @@ void double_fault()
 /*
  * coprocessor_segment_overrun
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void coprocessor_segment_overrun()
+void coprocessor_segment_overrun(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("coprocessor segment overrun!\n");
-    printf("coprocessor");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "coprocessor");
 }
 
 /*
  * invalid_TSS
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void invalid_TSS()
+void invalid_TSS(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("invalid_tss");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "invalid_tss");
 }
 
 /*
  * segment_not_present
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void segment_not_present()
+void segment_not_present(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("segment_not");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "segment_not");
 }
 
 /*
  * stack_segment_fault
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void stack_segment_fault()
+void stack_segment_fault(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("stack segment");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "stack segment");
 }
 
 /*
  * general_protection
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void general_protection()
+void general_protection(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("general");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "general");
 }
 
 /*
  * page_fault
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * interrupt handler the deals with the given interrupt, a fault just below
+ * the user stack grows the stack and returns, any other fault in user mode
+ * raises SEGFAULT
+ * input: fault_addr -- the faulting address from cr2
+ *        regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the interrupt type on screen and hold the control if
+ * it happened in the kernel
  */
-void page_fault()
+void page_fault(uint32_t fault_addr, hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("page fault");
-    // terminate_by_exception();
-    while(1) ;
+    account_page_fault();
+    if (grow_user_stack(fault_addr) == 0)
+        return;
+
+    exception_signal(regs, SEGFAULT, "page fault");
 }
 
 /*
@@ -367,37 +372,29 @@ void reserved_exception()
 /*
  * FPU_floating_point_error
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void FPU_floating_point_error()
+void FPU_floating_point_error(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("FPU");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "FPU");
 }
 
 /*
  * alignment_check
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void alignment_check()
+void alignment_check(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("alignment");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "alignment");
 }
 
 /*
@@ -421,19 +418,15 @@ void machine_check()
 /*
  * SIMD_floating_point_exception
  * decription:
- * interrupt handler the deals with the given interrupt
- * input: none
+ * exception handler, raises SEGFAULT on a process that took it in user mode
+ * input: regs -- the registers saved by the linker
  * output: none
- * sideffect: print the interrupt type on screen and hold the control
+ * sideffect: print the exception type on screen and hold the control if
+ * it happened in the kernel
  */
-void SIMD_floating_point_exception()
+void SIMD_floating_point_exception(hw_context_t *regs)
 {
-    cli();
-    clear();
-    // puts("divide_by_zero_error_exception!\n");
-    printf("SIMD");
-    while (1)
-        ;
+    exception_signal(regs, SEGFAULT, "SIMD");
 }
 
 /*
@@ -9,6 +9,10 @@
 #include "rtc_linker.h"
 #include "syscall_linker.h"
 #include "pit_linker.h"
+#include "serial_linker.h"
+#include "exception_linker.h"
+#include "signal.h"
+#include "pcb.h"
 
 #define initialize_zero         0
 #define devide_by_zero          0
@@ -44,6 +48,7 @@
 #define KEYBOARD_LINKER                     33
 #define RTC_LINKER                          40
 #define PIT_LINKER                          0x20
+#define SERIAL_LINKER                       0x24
 
 // system call
 #define SYSCALL_ONE                         1
@@ -60,26 +65,28 @@
 
 // initialize exception functions
 void initialize_idt();
-void division_by_zero();
+void exception_signal(hw_context_t *regs, int32_t signum, int8_t *name);
+void unknown_interrupt();
+void division_by_zero(hw_context_t *regs);
 void system_reserved();
 void non_maskable_interrupt();
 void break_point();
-void over_flow();
-void bound_range_exceeded();
-void invalid_opcode();
-void device_not_available();
+void over_flow(hw_context_t *regs);
+void bound_range_exceeded(hw_context_t *regs);
+void invalid_opcode(hw_context_t *regs);
+void device_not_available(hw_context_t *regs);
 void double_fault();
-void coprocessor_segment_overrun();
-void invalid_TSS();
-void segment_not_present();
-void stack_segment_fault();
-void general_protection();
-void page_fault();
+void coprocessor_segment_overrun(hw_context_t *regs);
+void invalid_TSS(hw_context_t *regs);
+void segment_not_present(hw_context_t *regs);
+void stack_segment_fault(hw_context_t *regs);
+void general_protection(hw_context_t *regs);
+void page_fault(uint32_t fault_addr, hw_context_t *regs);
 void reserved_exception();
-void FPU_floating_point_error();
-void alignment_check();
+void FPU_floating_point_error(hw_context_t *regs);
+void alignment_check(hw_context_t *regs);
 void machine_check();
-void SIMD_floating_point_exception();
+void SIMD_floating_point_exception(hw_context_t *regs);
 void SystemCall_temp();
 void Keyboard_input();
 
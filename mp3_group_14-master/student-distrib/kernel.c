@@ -14,6 +14,12 @@
 #include "do_sys.h"
 #include "pit.h"
 #include "schedule.h"
+#include "clock.h"
+#include "serial.h"
+#include "profile.h"
+#include "smp.h"
+#include "workqueue.h"
+#include "prezero.h"
 
 #define RUN_TESTS
 
@@ -88,6 +94,8 @@ void entry(unsigned long magic, unsigned long addr)
     /* Is the section header table of ELF valid? */
     if (CHECK_FLAG(mbi->flags, 5))
     {
+        // keep the kernel symbols for the profiler
+        profile_init(mbi);
         //elf_section_header_table_t *elf_sec = &(mbi->elf_sec);
         //printf("elf_sec: num = %u, size = 0x%#x, addr = 0x%#x, shndx = 0x%#x\n",
                //(unsigned)elf_sec->num, (unsigned)elf_sec->size,
@@ -156,6 +164,9 @@ void entry(unsigned long magic, unsigned long addr)
     /* Initialize devices, memory, filesystem, enable device interrupts on the
      * PIC, any other initialization stuff... */
 
+    // find the other processors while low memory is still reachable
+    smp_detect();
+
     // initialize the paging
     init_paging();
 
@@ -167,12 +178,18 @@ void entry(unsigned long magic, unsigned long addr)
     // Init the PIC
     i8259_init();
 
+    // COM1, the kernel log and the trace dump go out on it
+    serial_init();
+
     // initialize the RTC
     rtc_init();
 
     // initialize terminal
     initialize_new_ternimals();
 
+    // the keyboard echoes from its bottom half
+    keyboard_init();
+
     /* put paging and idt in different files while calling paging and idt in kernel.c */
 
     /* Enable interrupts */
@@ -183,12 +200,29 @@ void entry(unsigned long magic, unsigned long addr)
     //set the interrupt flag
     sti();
 
+    // calibrate the TSC for the monotonic clock
+    clock_init();
+
+    // start the other processors, they wait parked for now
+    smp_init();
+
+    // the worker threads run once the PIT has started the shells
+    workqueue_init();
+
+    // program frames are cleared in the background before execute needs them
+    prezero_init();
+
     // initialize PIT
     pit_init();
 
     /* Run tests */
     launch_tests();
 
+#ifdef RUN_BENCHMARKS
+    /* Time the hot paths, the results also go out on COM1 */
+    launch_benchmarks();
+#endif
+
 #ifdef RUN_TESTS
 
 #endif
@@ -1,5 +1,8 @@
 #include "keyboard.h"
 #include "paging.h"
+#include "kthread.h"
+#include "workqueue.h"
+#include "prezero.h"
 /* Reference from http://www.osdever.net/bkerndev/Docs/keyboard.htm */
 // map the typed possible 128 keyboard keys to the human readable characters
 
@@ -10,6 +13,23 @@ static unsigned char ctl_flag = 0;
 static unsigned char alt_flag = 0;
 static int buffer_ptr = 0;
 
+// the console position and video memory pointer, shared by the echo of
+// keyboard_bh and every terminal_write
+static spinlock_t terminal_lock = SPINLOCK_INIT("terminal");
+
+// scancodes keyboard_input leaves for keyboard_bh, the indices only grow
+static volatile uint8_t key_queue[KEY_QUEUE_SIZE];
+static volatile uint32_t key_queue_head = 0;
+static volatile uint32_t key_queue_tail = 0;
+
+// the serial dumps take seconds, they run on a worker thread
+static void trace_dump_work(work_t *work);
+static void spin_stats_work(work_t *work);
+static void exec_stats_work(work_t *work);
+static work_t trace_dump_item = WORK_INIT(trace_dump_work);
+static work_t spin_stats_item = WORK_INIT(spin_stats_work);
+static work_t exec_stats_item = WORK_INIT(exec_stats_work);
+
 unsigned char scan_table[128] =
     {
         0, 27, '1', '2', '3', '4', '5', '6', '7', '8',    /* 9 */
@@ -92,246 +112,416 @@ unsigned char scan_table_shift[128] =
 };
 
 /* 
- * keyboard_input
+ * keyboard_scancode
  * description: 
- * handle the keyboard input by getting the data from port
- * input: none
+ * the line discipline, apply one scancode to the modifier flags and the
+ * keyboard buffer of the terminal on the screen
+ * input: key_pressed -- the scancode read from the keyboard
  * output: none
- * side effect: print the typed input to the screen, update the cursor
+ * side effect: echo the typed character to the screen, wake a reader on enter
  */
-void keyboard_input()
+void keyboard_scancode(uint8_t key_pressed)
 {
-    // clear the input for the interrupt
-    cli();
-
-    // initialize variables
-    int key_pressed;
-    uint8_t key_in_buffer;
-    uint32_t old_pte = get_old_pte();
+    uint8_t key_in_buffer = key_pressed;
 
-    // set the pte mapping to video memory
-    set_pte(VID_INDEX,VID_ADDR);
-
-    // update the x, y coordinates
-    set_x(terminals[get_current_looking_terminal()].x_pos);
-    set_y(terminals[get_current_looking_terminal()].y_pos);
-
-    // check where a key is pressed
-    if ((key_pressed = inb(KEYBOARD_PORT)))
+    /* 
+     * check whether the input is in the keyboard mapping table.
+     * If so, read from the table which key is been pressed and 
+     * print it to the screen
+     */
+    int check = KEYBOARD_MAP_TABLE - key_pressed;
+    switch (key_pressed)
     {
-        // get the input from the port
-        key_in_buffer = (uint8_t)key_pressed;
-        /* 
-         * check whether the input is in the keyboard mapping table.
-         * If so, read from the table which key is been pressed and 
-         * print it to the screen
-         */
-        int check = KEYBOARD_MAP_TABLE - key_pressed;
-        switch (key_pressed)
+    case RIGHT_SHIFT_PRESS:
+        right_shift_flag = ONE;
+        break;
+    case LEFT_SHIFT_PRESS:
+        left_shift_flag = ONE;
+        break;
+    case TAB:
+        break;
+    case RIGHT_SHIFT_RELEASE:
+        right_shift_flag = ZERO;
+        break;
+    case LEFT_SHIFT_RELEASE:
+        left_shift_flag = ZERO;
+        break;
+    case CTRL_PRESS:
+        ctl_flag = ONE;
+        break;
+    case CTRL_RELEASE:
+        ctl_flag = ZERO;
+        break;
+    case ALT_PRESS:
+        alt_flag = ONE;
+        break;
+    case ALT_RELEASE:
+        alt_flag = ZERO;
+        break;
+    case CAPS_PRESS:
+        caps_flag = (caps_flag == ONE) ? ZERO : ONE;
+        break;
+    case CAPS_RELEASE:
+        break;
+    case BACK_SPACE:
+        if (buffer_ptr > ZERO)
         {
-        case RIGHT_SHIFT_PRESS:
-            right_shift_flag = ONE;
-            break;
-        case LEFT_SHIFT_PRESS:
-            left_shift_flag = ONE;
-            break;
-        case TAB:
-            break;
-        case RIGHT_SHIFT_RELEASE:
-            right_shift_flag = ZERO;
+            buffer_ptr--;
+            keyboard_buffer[buffer_ptr] = '\0';
+            putc('\b');
+        }
+
+        break;
+    case ENTER:
+        if (terminals[get_current_looking_terminal()].enter_flag == LOW){
+             key_in_buffer = scan_table[key_pressed];
+             if (buffer_ptr < KEY_BUFFER_SIZE - 1)
+                 keyboard_buffer[buffer_ptr++] = key_in_buffer;
+            putc('\n');
+            terminals[get_current_looking_terminal()].enter_flag = HIGH;
+            wake_terminal(get_current_looking_terminal());
+        }
+        //calls the test to echo the buffer on the screen
+        //read_write_test();
+        //memset(keyboard_buffer, '\0', KEY_BUFFER_SIZE);
+        //buffer_ptr = ZERO;
+        //if no test here, should clear the key_board_buffer here.
+        break;
+    case F1_PRESS:
+        
+        if (alt_flag)
+        {
+            switch_screen(TERM_ZERO);
             break;
-        case LEFT_SHIFT_RELEASE:
-            left_shift_flag = ZERO;
+        }
+        break;
+    case F2_PRESS:
+        
+        if (alt_flag)
+        {
+            switch_screen(TERM_ONE);
             break;
-        case CTRL_PRESS:
-            ctl_flag = ONE;
+        }
+        break;
+    case F3_PRESS:
+        
+        if (alt_flag)
+        {
+            switch_screen(TERM_TWO);
             break;
-        case CTRL_RELEASE:
-            ctl_flag = ZERO;
+        }
+        break;
+    case C_PRESSED:
+        // ctrl+c interrupts the program on the terminal on the screen
+        if (ctl_flag)
+        {
+            if (get_current_looking_terminal() == get_current_running_terminal() &&
+                kthread_current() == KTHREAD_NONE)
+                send_signal(get_pcb()->pid, INTERRUPT);
+            else
+                send_signal(terminals[get_current_looking_terminal()].current_pid, INTERRUPT);
             break;
-        case ALT_PRESS:
-            alt_flag = ONE;
+        }
+    case T_PRESSED:
+        // ctrl+t dumps the trace buffer to COM1
+        if (ctl_flag)
+        {
+            queue_work(&trace_dump_item);
             break;
-        case ALT_RELEASE:
-            alt_flag = ZERO;
+        }
+    case K_PRESSED:
+        // ctrl+k dumps the lock statistics to COM1
+        if (ctl_flag)
+        {
+            queue_work(&spin_stats_item);
             break;
-        case CAPS_PRESS:
-            caps_flag = (caps_flag == ONE) ? ZERO : ONE;
+        }
+    case E_PRESSED:
+        // ctrl+e dumps the execute latency statistics to COM1
+        if (ctl_flag)
+        {
+            queue_work(&exec_stats_item);
             break;
-        case CAPS_RELEASE:
+        }
+    case L_PRESS:
+        if (ctl_flag)
+        {
+            clear();
+            printf("391OS> ");
+            puts(keyboard_buffer);
             break;
-        case BACK_SPACE:
-            if (buffer_ptr > ZERO)
-            {
-                buffer_ptr--;
-                keyboard_buffer[buffer_ptr] = '\0';
-                putc('\b');
-            }
-
+        }
+    default:
+        if (check <= ZERO)
             break;
-        case ENTER:
-            if (terminals[get_current_looking_terminal()].enter_flag == LOW){
-                 key_in_buffer = scan_table[key_pressed];
-                 if (buffer_ptr < KEY_BUFFER_SIZE - 1)
-                     keyboard_buffer[buffer_ptr++] = key_in_buffer;
-                putc('\n');
-                terminals[get_current_looking_terminal()].enter_flag = HIGH;
-            }
-            //calls the test to echo the buffer on the screen
-            //read_write_test();
-            //memset(keyboard_buffer, '\0', KEY_BUFFER_SIZE);
-            //buffer_ptr = ZERO;
-            //if no test here, should clear the key_board_buffer here.
+        if (ctl_flag)
             break;
-        case F1_PRESS:
-            
-            if (alt_flag)
-            {
-                switch_screen(TERM_ZERO);
+        if ((!left_shift_flag) && (!caps_flag) && (!right_shift_flag))
+        {
+            key_in_buffer = scan_table[key_pressed];
+            //buffer ptr points to 127 means it is pointing to the end of the buffer
+            if (key_in_buffer == ZERO)
                 break;
-            }
-            break;
-        case F2_PRESS:
-            
-            if (alt_flag)
+            if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
             {
-                switch_screen(TERM_ONE);
-                break;
+                keyboard_buffer[buffer_ptr++] = key_in_buffer;
+                putc(key_in_buffer);
             }
-            break;
-        case F3_PRESS:
-            
-            if (alt_flag)
-            {
-                switch_screen(TERM_TWO);
+        }
+        else if ((left_shift_flag || right_shift_flag) && (caps_flag && is_letter(key_pressed)))
+        {
+            //at least one shift was pressed and capslock was pressed
+            key_in_buffer = scan_table[key_pressed];
+            if (key_in_buffer == ZERO)
                 break;
-            }
-            break;
-        case L_PRESS:
-            if (ctl_flag)
+            if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
             {
-                clear();
-                printf("391OS> ");
-                puts(keyboard_buffer);
-                break;
+                keyboard_buffer[buffer_ptr++] = key_in_buffer;
+                putc(key_in_buffer);
             }
-        default:
-            if (check <= ZERO)
-                break;
-            if (ctl_flag)
+        }
+        else if ((!(left_shift_flag || right_shift_flag)) && caps_flag && !is_letter(key_pressed)) //only caps flag is pressed but not the shift
+        {
+            key_in_buffer = scan_table[key_pressed];
+            if (key_in_buffer == ZERO)
                 break;
-            if ((!left_shift_flag) && (!caps_flag) && (!right_shift_flag))
+            if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
             {
-                key_in_buffer = scan_table[key_pressed];
-                //buffer ptr points to 127 means it is pointing to the end of the buffer
-                if (key_in_buffer == ZERO)
-                    break;
-                if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
-                {
-                    keyboard_buffer[buffer_ptr++] = key_in_buffer;
-                    putc(key_in_buffer);
-                }
+                keyboard_buffer[buffer_ptr++] = key_in_buffer;
+                putc(key_in_buffer);
             }
-            else if ((left_shift_flag || right_shift_flag) && (caps_flag && is_letter(key_pressed)))
-            {
-                //at least one shift was pressed and capslock was pressed
-                key_in_buffer = scan_table[key_pressed];
-                if (key_in_buffer == ZERO)
-                    break;
-                if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
-                {
-                    keyboard_buffer[buffer_ptr++] = key_in_buffer;
-                    putc(key_in_buffer);
-                }
-            }
-            else if ((!(left_shift_flag || right_shift_flag)) && caps_flag && !is_letter(key_pressed)) //only caps flag is pressed but not the shift
-            {
-                key_in_buffer = scan_table[key_pressed];
-                if (key_in_buffer == ZERO)
-                    break;
-                if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
-                {
-                    keyboard_buffer[buffer_ptr++] = key_in_buffer;
-                    putc(key_in_buffer);
-                }
-            }
-            else
+        }
+        else
+        {
+            key_in_buffer = scan_table_shift[key_pressed];
+            if (key_in_buffer == ZERO)
+                break;
+            if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
             {
-                key_in_buffer = scan_table_shift[key_pressed];
-                if (key_in_buffer == ZERO)
-                    break;
-                if (buffer_ptr < KEY_BUFFER_SIZE - ONE)
-                {
-                    keyboard_buffer[buffer_ptr++] = key_in_buffer;
-                    putc(key_in_buffer);
-                }
+                keyboard_buffer[buffer_ptr++] = key_in_buffer;
+                putc(key_in_buffer);
             }
         }
     }
-    // input status ready, read from keyboard
-    // udpayey the x, y coordinates and the cursor position
-    terminals[get_current_looking_terminal()].x_pos = get_x();
-    terminals[get_current_looking_terminal()].y_pos = get_y();
-    update_cursor(get_x(), get_y());
+}
+
+/* 
+ * trace_dump_work
+ * description: 
+ * ctrl+t, dump the trace buffer to COM1 from a worker thread
+ * input: work -- not used
+ * output: none
+ * side effect: busy-waits on the UART
+ */
+static void trace_dump_work(work_t *work)
+{
+    trace_dump();
+}
+
+/* 
+ * spin_stats_work
+ * description: 
+ * ctrl+k, dump the lock statistics to COM1 from a worker thread
+ * input: work -- not used
+ * output: none
+ * side effect: busy-waits on the UART
+ */
+static void spin_stats_work(work_t *work)
+{
+    spin_stats_dump();
+}
+
+/* 
+ * exec_stats_work
+ * description: 
+ * ctrl+e, dump the execute latency statistics to COM1 from a worker thread
+ * input: work -- not used
+ * output: none
+ * side effect: busy-waits on the UART
+ */
+static void exec_stats_work(work_t *work)
+{
+    exec_stats_dump();
+}
+
+/* 
+ * keyboard_bh
+ * description: 
+ * the bottom half of the keyboard, decode the queued scancodes and echo
+ * them with interrupts on
+ * input: none
+ * output: none
+ * side effect: print the typed input to the screen, update the cursor
+ */
+static void keyboard_bh()
+{
+    uint8_t key_pressed;
+    uint32_t old_video_mem;
+
+    spin_lock(&terminal_lock);
+    old_video_mem = get_video_mem();
+
+    while (key_queue_head != key_queue_tail)
+    {
+        key_pressed = key_queue[key_queue_head & (KEY_QUEUE_SIZE - ONE)];
+        key_queue_head++;
+
+        // echo goes to the terminal on the screen
+        set_video_mem(VID_ADDR);
+
+        // update the x, y coordinates
+        set_x(terminals[get_current_looking_terminal()].x_pos);
+        set_y(terminals[get_current_looking_terminal()].y_pos);
+
+        keyboard_scancode(key_pressed);
+
+        // udpayey the x, y coordinates and the cursor position
+        terminals[get_current_looking_terminal()].x_pos = get_x();
+        terminals[get_current_looking_terminal()].y_pos = get_y();
+        update_cursor(get_x(), get_y());
+    }
+
+    // restore the console output of the running terminal
+    set_video_mem(old_video_mem);
+    spin_unlock(&terminal_lock);
+}
+
+/* 
+ * keyboard_init
+ * description: 
+ * set up the bottom half of the keyboard, before interrupts are enabled
+ * input: none
+ * output: none
+ * side effect: none
+ */
+void keyboard_init()
+{
+    softirq_register(SOFTIRQ_KEYBOARD, keyboard_bh);
+}
+
+/* 
+ * keyboard_input
+ * description: 
+ * the keyboard interrupt, only queue the scancode for keyboard_bh so
+ * interrupts are not held off while it is echoed
+ * input: none
+ * output: none
+ * side effect: a scancode that finds the queue full is dropped
+ */
+void keyboard_input()
+{
+    int key_pressed;
+
+    // check where a key is pressed
+    if ((key_pressed = inb(KEYBOARD_PORT)))
+    {
+        if (key_queue_tail - key_queue_head < KEY_QUEUE_SIZE)
+        {
+            key_queue[key_queue_tail & (KEY_QUEUE_SIZE - ONE)] = (uint8_t)key_pressed;
+            key_queue_tail++;
+        }
+        softirq_raise(SOFTIRQ_KEYBOARD);
+    }
 
-    // send EOI and map the pte back to original address
     send_eoi(IRQ_NUM_ONE);
-    set_pte(VID_INDEX,old_pte);
 }
 
 /* 
- * terminal_write
+ * terminal_write_chunk
  * description: 
- * write the buffer value to the screen.
+ * write part of a terminal_write to the screen, or to the buffer of the
+ * running terminal when another one is shown, under the terminal lock
  * input: 
- * int32_t fd
- * buf: The buffer to write from
- * nbytes: the number of bytes needs to write.
- * output: The number of bytes actually write. -1 if buffer is NULL
- * side effect: none
+ * buf: the characters to write
+ * nbytes: how many, at most TERMINAL_WRITE_CHUNK
+ * output: none
+ * side effect: no switch to another terminal while it runs
  */
-int32_t terminal_write(int32_t fd, const void *buf, int32_t nbytes)
+static void terminal_write_chunk(const int8_t *buf, int32_t nbytes)
 {
-    cli();
     int i;
-    int8_t *tmp;
 
-    // sanity check
-    if (!buf)
-        return -1;
+    spin_lock(&terminal_lock);
 
     // if the current looking is not the current running, write to the buffer
     if (get_current_running_terminal() != get_current_looking_terminal()) {
-        // calculate the current running buffer addr and remap the video buffer
+        // calculate the current running buffer addr and write into it
         uint32_t running_pos = VID_ADDR + (get_current_running_terminal() + ONE) * _4KB;
-        set_pte(VID_INDEX, running_pos);
+        set_video_mem(running_pos);
         // update the x,y coordinates
         set_x(terminals[get_current_running_terminal()].x_pos);
         set_y(terminals[get_current_running_terminal()].y_pos);
     }
 
     // write the contents to the video memory and update the x,y coordinates
-    tmp = (int8_t *)buf;
     for (i = 0; i < nbytes; i++)
     {
-        putc(tmp[i]);
+        putc(buf[i]);
     }
     terminals[get_current_running_terminal()].x_pos = get_x();
     terminals[get_current_running_terminal()].y_pos = get_y();
 
     // if the current looking is the same as the current running, only update the cursor
-    // otherwise map pte back to the video memory, save the x,y coordinates and update the cursor
+    // otherwise write to the video memory again, save the x,y coordinates and update the cursor
     if (get_current_looking_terminal() == get_current_running_terminal()){
         update_cursor(get_x(), get_y());
     }else{
-        set_pte(VID_INDEX, VID_ADDR);
+        set_video_mem(VID_ADDR);
         set_x(terminals[get_current_looking_terminal()].x_pos);
         set_y(terminals[get_current_looking_terminal()].y_pos);
         update_cursor(get_x(), get_y());
     }
+
+    spin_unlock(&terminal_lock);
+}
+
+/* 
+ * terminal_write
+ * description: 
+ * write the buffer value to the screen.
+ * input: 
+ * int32_t fd
+ * buf: The buffer to write from
+ * nbytes: the number of bytes needs to write.
+ * output: The number of bytes actually write. -1 if buffer is NULL
+ * side effect: other terminals and the echo get in between chunks of the write
+ */
+int32_t terminal_write(int32_t fd, const void *buf, int32_t nbytes)
+{
+    int32_t i;
+
+    // sanity check
+    if (!buf)
+        return -1;
+
+    // a long write does not hold the others off for all of its length
+    for (i = 0; i < nbytes; i += TERMINAL_WRITE_CHUNK)
+    {
+        if (nbytes - i < TERMINAL_WRITE_CHUNK)
+            terminal_write_chunk((const int8_t *)buf + i, nbytes - i);
+        else
+            terminal_write_chunk((const int8_t *)buf + i, TERMINAL_WRITE_CHUNK);
+    }
     return nbytes;
 }
 
+/* 
+ * terminal_poll
+ * description: 
+ * the poll entry of stdin and stdout. A line is ready once enter was
+ * pressed on the terminal, terminal_read then returns it at once
+ * input: 
+ * int32_t fd
+ * output: POLLIN when a line is ready, writes never wait
+ * side effect: none
+ */
+int32_t terminal_poll(int32_t fd)
+{
+    if (terminals[get_current_running_terminal()].enter_flag == HIGH)
+        return POLLIN | POLLOUT;
+    return POLLOUT;
+}
+
 /* 
  * terminal_read
  * description: 
@@ -340,14 +530,14 @@ int32_t terminal_write(int32_t fd, const void *buf, int32_t nbytes)
  * int32_t fd
  * buf: The buffer to read to from the keyboard_buffer
  * nbytes: the number of bytes needs to read.
- * output: The number of bytes actually read.
+ * output: The number of bytes actually read, -EAGAIN when no line is ready
+ * and fd is O_NONBLOCK.
  * side effect: fill buf with the values in keyboard_buffer
  */
 int32_t terminal_read(int32_t fd, void *buf, int32_t nbytes)
 {
     int8_t *tmp;
-    // reset the enter flag to low to clear the flag
-    terminals[get_current_running_terminal()].enter_flag = LOW;
+    uint32_t flags;
 
     // sanity check
     if (!buf)
@@ -355,13 +545,25 @@ int32_t terminal_read(int32_t fd, void *buf, int32_t nbytes)
     if (nbytes > KEY_BUFFER_SIZE)
         nbytes = KEY_BUFFER_SIZE;
 
-    // wait for the current running terminal enter "Enter"
-    while (1)
+    // wait for the current running terminal enter "Enter", sleeping in hlt
+    cli_and_save(flags);
+    if ((get_pcb()->descriptors[fd].f_status & O_NONBLOCK) &&
+        terminals[get_current_running_terminal()].enter_flag != HIGH)
     {
-        if (terminals[get_current_running_terminal()].enter_flag == HIGH){
-            break;
+        restore_flags(flags);
+        return -EAGAIN;
+    }
+    while (terminals[get_current_running_terminal()].enter_flag != HIGH)
+    {
+        // a signal that kills the process interrupts the read
+        if (signal_kill_pending())
+        {
+            restore_flags(flags);
+            return -1;
         }
+        idle_wait();
     }
+    restore_flags(flags);
 
     // after receive the enter, clear the flag
     terminals[get_current_running_terminal()].enter_flag = LOW;
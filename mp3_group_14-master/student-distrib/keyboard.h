@@ -7,6 +7,11 @@
 #include "types.h"
 #include "tests.h"
 #include "schedule.h"
+#include "signal.h"
+#include "trace.h"
+#include "spinlock.h"
+#include "softirq.h"
+#include "poll.h"
 
 #define KEYBOARD_PORT          0x60
 #define KEYBOARD_MAP_TABLE     0x80
@@ -24,6 +29,10 @@
 #define IRQ_NUM_ONE            1
 #define BACK_SPACE             0x0E
 #define KEY_BUFFER_SIZE        128
+// terminal_write holds off switches and the echo for at most this many characters
+#define TERMINAL_WRITE_CHUNK   64
+// scancodes waiting for the bottom half, a power of two
+#define KEY_QUEUE_SIZE         64
 #define ENTER                  0x1C
 #define TAB                    0x0F
 #define ONE                    1
@@ -34,6 +43,10 @@
 #define L_PRESSED              0x26
 #define Z_PRESSED              0x2C
 #define M_PRESSED              0x32
+#define C_PRESSED              0x2E
+#define T_PRESSED              0x14
+#define K_PRESSED              0x25
+#define E_PRESSED              0x12
 
 #define F1_PRESS               0x3B
 #define F2_PRESS               0x3C
@@ -61,6 +74,8 @@ extern int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes);
 
 extern int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes);
 
+extern int32_t terminal_poll(int32_t fd);
+
 int8_t keyboard_buffer[KEY_BUFFER_SIZE];
 
 //To test for the read wnad write function
@@ -69,6 +84,9 @@ int8_t keyboard_buffer_2[KEY_BUFFER_SIZE];
 // handler for keyboard input
 extern void keyboard_input();
 
+extern void keyboard_init();
+extern void keyboard_scancode(uint8_t key_pressed);
+
 //local test for read and write
 void read_write_test();
 
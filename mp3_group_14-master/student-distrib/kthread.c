@@ -0,0 +1,216 @@
+#include "kthread.h"
+#include "lib.h"
+#include "schedule.h"
+#include "pit.h"
+#include "pcb.h"
+
+typedef union kthread_stack {
+  pcb_t pcb;
+  uint8_t stack[KTHREAD_STACK_SIZE];
+} kthread_stack_t;
+
+kthread_t kthreads[KTHREAD_MAX];
+static kthread_stack_t kthread_stacks[KTHREAD_MAX] __attribute__((aligned (KTHREAD_STACK_SIZE)));
+
+// the thread on the processor, KTHREAD_NONE while a terminal's process is
+static volatile int32_t kthread_running = KTHREAD_NONE;
+// where kthread_pick continues its round robin
+static uint32_t kthread_last = 0;
+
+/*
+ * kthread_create
+ *   DESCRIPTION: set up a kernel thread, it first runs when pit_handler
+ *                picks it. The thread function must not return, one that
+ *                does leaves its thread waiting for good
+ *   INPUTS: const int8_t *name -- the name in its pcb
+ *           kthread_fn_t fn -- what the thread runs
+ *           void *arg -- handed to fn
+ *   OUTPUTS: none
+ *   RETURN VALUE: the thread id, -1 when all KTHREAD_MAX are taken
+ *   SIDE EFFECTS: none
+ */
+int32_t kthread_create(const int8_t *name, kthread_fn_t fn, void *arg)
+{
+  int32_t id;
+  uint32_t flags;
+  pcb_t *pcb;
+
+  if (fn == NULL) return -1;
+
+  cli_and_save(flags);
+  for (id = 0; id < KTHREAD_MAX; id++)
+    if (!kthreads[id].used) break;
+  if (id == KTHREAD_MAX)
+  {
+    restore_flags(flags);
+    return -1;
+  }
+
+  pcb = &kthread_stacks[id].pcb;
+  memset(pcb, 0, sizeof(pcb_t));
+  pcb->pid = KTHREAD_PID_BASE + id;
+  pcb->parent_pid = -1;
+  strncpy(pcb->name, name, PROCESS_NAME_LEN);
+  pcb->name[PROCESS_NAME_LEN] = '\0';
+
+  kthreads[id].fn = fn;
+  kthreads[id].arg = arg;
+  kthreads[id].started = 0;
+  kthreads[id].waiting = NO;
+  kthreads[id].used = 1;
+  restore_flags(flags);
+  return id;
+}
+
+/*
+ * kthread_current
+ *   DESCRIPTION: which kernel thread is on the processor
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: the thread id, KTHREAD_NONE while a process runs
+ *   SIDE EFFECTS: none
+ */
+int32_t kthread_current()
+{
+  return kthread_running;
+}
+
+/*
+ * kthread_runnable
+ *   DESCRIPTION: whether a kernel thread has something to do
+ *   INPUTS: int32_t id -- the thread, KTHREAD_NONE is never runnable
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if it exists and is not waiting, 0 otherwise
+ *   SIDE EFFECTS: none
+ */
+int32_t kthread_runnable(int32_t id)
+{
+  if (id < 0 || id >= KTHREAD_MAX) return 0;
+  return kthreads[id].used && kthreads[id].waiting == NO;
+}
+
+/*
+ * kthread_pick
+ *   DESCRIPTION: round robin over the kernel threads, skipping those
+ *                waiting
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: the next runnable thread, KTHREAD_NONE if there is none
+ *   SIDE EFFECTS: the next pick starts after this one
+ */
+int32_t kthread_pick()
+{
+  uint32_t i, id;
+
+  for (i = 1; i <= KTHREAD_MAX; i++)
+  {
+    id = (kthread_last + i) % KTHREAD_MAX;
+    if (kthread_runnable(id))
+    {
+      kthread_last = id;
+      return id;
+    }
+  }
+  return KTHREAD_NONE;
+}
+
+/*
+ * kthread_enter
+ *   DESCRIPTION: called by pit_handler as it switches to a kernel thread,
+ *                or with KTHREAD_NONE as it switches back to a process
+ *   INPUTS: int32_t id -- the thread about to run
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: counts the switch on the thread's pcb
+ */
+void kthread_enter(int32_t id)
+{
+  kthread_running = id;
+  if (id != KTHREAD_NONE)
+    kthread_stacks[id].pcb.acct.switches++;
+}
+
+/*
+ * kthread_main
+ *   DESCRIPTION: called by kthread_start at the bottom of every kernel
+ *                thread stack, runs the thread function with interrupts on
+ *   INPUTS: int32_t id -- the thread
+ *   OUTPUTS: none
+ *   RETURN VALUE: never returns
+ *   SIDE EFFECTS: none
+ */
+void kthread_main(int32_t id)
+{
+  sti();
+  kthreads[id].fn(kthreads[id].arg);
+
+  // nothing to go back to, wait for good
+  cli();
+  while (1)
+    kthread_wait();
+}
+
+/*
+ * kthread_start
+ *   DESCRIPTION: called by pit_handler the first time it switches to a
+ *                thread, after the EOI. Moves to the top of the thread's
+ *                stack and runs it
+ *   INPUTS: int32_t id -- the thread, already entered
+ *   OUTPUTS: none
+ *   RETURN VALUE: never returns
+ *   SIDE EFFECTS: the PIT frame of the switch is left on the old stack,
+ *                 where pit_handler saved it
+ */
+void kthread_start(int32_t id)
+{
+  uint32_t top = (uint32_t)&kthread_stacks[id] + KTHREAD_STACK_SIZE - KTHREAD_STACK_OFFSET;
+
+  kthreads[id].started = 1;
+  asm volatile(
+      "movl %0, %%esp \n"
+      "movl %0, %%ebp \n"
+      "pushl %1 \n"
+      "call kthread_main \n"
+      :
+      : "r"(top), "r"(id)
+      : "memory");
+}
+
+/*
+ * kthread_wait
+ *   DESCRIPTION: block the running kernel thread until kthread_wake. Like
+ *                idle_wait, called with interrupts off and returns with
+ *                them off, so the caller can check its wait condition
+ *                without losing a wakeup
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void kthread_wait()
+{
+  int32_t id = kthread_running;
+
+  if (id == KTHREAD_NONE) return;
+  kthreads[id].waiting = YES;
+  // sti takes effect after the next instruction, so hlt cannot miss an interrupt
+  asm volatile("sti; hlt; cli" : : : "memory", "cc");
+  kthreads[id].waiting = NO;
+}
+
+/*
+ * kthread_wake
+ *   DESCRIPTION: make a waiting kernel thread runnable again, and bring
+ *                the PIT back to periodic mode so the scheduler gets to it
+ *   INPUTS: int32_t id -- the thread
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void kthread_wake(int32_t id)
+{
+  if (id < 0 || id >= KTHREAD_MAX || !kthreads[id].used) return;
+  if (kthreads[id].waiting == NO) return;
+  kthreads[id].waiting = NO;
+  pit_kick();
+}
@@ -0,0 +1,48 @@
+#ifndef KTHREAD_H
+#define KTHREAD_H
+
+#include "types.h"
+
+#define KTHREAD_MAX         4
+#define KTHREAD_NONE        -1
+// a kernel stack, with a pcb at its base like those of the processes, so
+// get_pcb and the accounting work on a kernel thread too
+#define KTHREAD_STACK_SIZE  0x2000
+#define KTHREAD_STACK_OFFSET 4
+// the pids kernel threads get, above those of the processes
+#define KTHREAD_PID_BASE    0x100
+
+typedef void (*kthread_fn_t)(void *arg);
+
+/* a kernel thread, scheduled by pit_handler next to the terminals */
+typedef struct kthread {
+  uint32_t used;
+  uint32_t started;           /* 0 until it first runs on its stack */
+  volatile int32_t waiting;   /* YES while it sleeps in kthread_wait */
+  uint32_t saved_esp;
+  uint32_t saved_ebp;
+  kthread_fn_t fn;
+  void *arg;
+} kthread_t;
+
+extern kthread_t kthreads[KTHREAD_MAX];
+
+int32_t kthread_create(const int8_t *name, kthread_fn_t fn, void *arg);
+
+int32_t kthread_current();
+
+int32_t kthread_runnable(int32_t id);
+
+int32_t kthread_pick();
+
+void kthread_enter(int32_t id);
+
+void kthread_start(int32_t id);
+
+void kthread_main(int32_t id);
+
+void kthread_wait();
+
+void kthread_wake(int32_t id);
+
+#endif
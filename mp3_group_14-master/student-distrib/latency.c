@@ -0,0 +1,196 @@
+#include "latency.h"
+#include "lib.h"
+#include "clock.h"
+
+static irq_latency_t irq_latency[LATENCY_IRQS];
+
+/*
+ * latency_record
+ *   DESCRIPTION: count a time in a histogram and keep the largest
+ *   INPUTS: uint32_t *histogram -- LATENCY_BUCKETS counters
+ *           uint32_t *max -- the largest time so far
+ *           uint64_t cycles -- the time
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+static void latency_record(uint32_t *histogram, uint32_t *max, uint64_t cycles)
+{
+  uint32_t bucket = 0;
+  uint64_t v = cycles >> LATENCY_SHIFT;
+
+  while (v != 0 && bucket < LATENCY_BUCKETS - 1)
+  {
+    v >>= 1;
+    bucket++;
+  }
+  histogram[bucket]++;
+
+  if (cycles > LATENCY_SATURATE) cycles = LATENCY_SATURATE;
+  if (cycles > *max) *max = (uint32_t)cycles;
+}
+
+/*
+ * irq_latency_enter
+ *   DESCRIPTION: called by the linkers first thing on an interrupt. For a
+ *                periodic source, how late it is against when the PIC
+ *                should have raised it is its latency. The period is only
+ *                as good as the TSC calibration and the crystal of the
+ *                source, so it is trimmed to the least delayed interrupt
+ *                of every window, and a settling source is not counted
+ *   INPUTS: uint32_t irq -- the irq line
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: starts timing the handler
+ */
+void irq_latency_enter(uint32_t irq)
+{
+  irq_latency_t *l;
+  uint64_t now = rdtsc();
+  uint64_t late;
+
+  if (irq >= LATENCY_IRQS) return;
+  l = &irq_latency[irq];
+  l->entry = now;
+  l->stat.count++;
+
+  if (l->clocks == 0) return;
+  if (l->period == 0)
+  {
+    // the TSC rate is not known before clock_init
+    if (clock_tsc_khz() == 0) return;
+    l->period = div64_32((uint64_t)l->clocks * clock_tsc_khz() * HZ_PER_KHZ, l->clock_hz, NULL);
+  }
+
+  // the first interrupt after a change of period sets the anchor
+  if (l->expected == 0)
+  {
+    l->expected = now + l->period;
+    l->window_min = l->period;
+    l->window_count = 0;
+    l->windows = 0;
+    return;
+  }
+
+  if (now < l->expected)
+  {
+    // an interrupt can not come before it is raised, the period is too long
+    l->period -= (l->expected - now) >> LATENCY_WINDOW_SHIFT;
+    l->expected = now + l->period;
+    late = 0;
+  }
+  else
+  {
+    late = now - l->expected;
+    if (late >= l->period)
+    {
+      // held off a whole period, the PIC dropped at least one assertion
+      l->stat.overruns++;
+      l->expected = now + l->period;
+      return;
+    }
+    l->expected += l->period;
+  }
+
+  if (l->windows >= LATENCY_SETTLE)
+    latency_record(l->stat.latency, &l->stat.max_latency, late);
+
+  // the least delayed interrupt of the window counts as on time, what the
+  // whole window was late by is drift
+  if (late < l->window_min) l->window_min = late;
+  if (++l->window_count == LATENCY_WINDOW)
+  {
+    l->expected += l->window_min;
+    l->period += l->window_min >> LATENCY_WINDOW_SHIFT;
+    l->window_min = l->period;
+    l->window_count = 0;
+    if (l->windows < LATENCY_SETTLE) l->windows++;
+  }
+}
+
+/*
+ * irq_latency_eoi
+ *   DESCRIPTION: called by send_eoi, the handler of the irq is done
+ *   INPUTS: uint32_t irq -- the irq line
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void irq_latency_eoi(uint32_t irq)
+{
+  irq_latency_t *l;
+
+  if (irq >= LATENCY_IRQS) return;
+  l = &irq_latency[irq];
+  if (l->entry == 0) return;
+  latency_record(l->stat.handler, &l->stat.max_handler, rdtsc() - l->entry);
+  l->entry = 0;
+}
+
+/*
+ * irq_latency_period
+ *   DESCRIPTION: tell how often a source interrupts, as a number of clocks
+ *                of its own oscillator
+ *   INPUTS: uint32_t irq -- the irq line
+ *           uint32_t clocks -- clocks per interrupt, 0 when not periodic
+ *           uint32_t clock_hz -- the rate of the oscillator
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the next interrupt starts a new anchor
+ */
+void irq_latency_period(uint32_t irq, uint32_t clocks, uint32_t clock_hz)
+{
+  uint32_t flags;
+  irq_latency_t *l;
+
+  if (irq >= LATENCY_IRQS || clock_hz == 0) return;
+  l = &irq_latency[irq];
+
+  cli_and_save(flags);
+  l->clocks = clocks;
+  l->clock_hz = clock_hz;
+  l->period = 0;
+  l->expected = 0;
+  restore_flags(flags);
+}
+
+/*
+ * irq_latency_read
+ *   DESCRIPTION: copy the statistics of an irq
+ *   INPUTS: uint32_t irq -- the irq line
+ *   OUTPUTS: irq_stat_t *buf -- where to copy them
+ *   RETURN VALUE: 0 for success, -1 for a bad irq
+ *   SIDE EFFECTS: none
+ */
+int32_t irq_latency_read(uint32_t irq, irq_stat_t *buf)
+{
+  uint32_t flags;
+
+  if (irq >= LATENCY_IRQS || buf == NULL) return -1;
+
+  cli_and_save(flags);
+  memcpy(buf, &irq_latency[irq].stat, sizeof(irq_stat_t));
+  restore_flags(flags);
+  buf->tsc_khz = clock_tsc_khz();
+  return 0;
+}
+
+/*
+ * irq_latency_reset
+ *   DESCRIPTION: clear the statistics of an irq, e.g. before a run that
+ *                is to be compared with an earlier one
+ *   INPUTS: uint32_t irq -- the irq line
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the anchor of a periodic source is kept
+ */
+void irq_latency_reset(uint32_t irq)
+{
+  uint32_t flags;
+
+  if (irq >= LATENCY_IRQS) return;
+
+  cli_and_save(flags);
+  memset(&irq_latency[irq].stat, 0, sizeof(irq_stat_t));
+  restore_flags(flags);
+}
@@ -0,0 +1,58 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "types.h"
+
+// the irq lines of the two PICs
+#define LATENCY_IRQS        16
+
+// histogram bucket 0 holds times below 2^LATENCY_SHIFT cycles, each next
+// one twice as much, and the last one everything longer
+#define LATENCY_BUCKETS     16
+#define LATENCY_SHIFT       8
+
+// a periodic source is re-anchored to its least delayed interrupt every
+// 2^LATENCY_WINDOW_SHIFT interrupts, which also trims the period
+#define LATENCY_WINDOW_SHIFT 4
+#define LATENCY_WINDOW      (1 << LATENCY_WINDOW_SHIFT)
+// windows a periodic source gets to settle before its latency counts
+#define LATENCY_SETTLE      2
+
+#define LATENCY_SATURATE    0xFFFFFFFF
+#define HZ_PER_KHZ          1000
+
+/* what the irqstat system call copies out for one irq */
+typedef struct irq_stat {
+  uint32_t tsc_khz;       /* to turn the cycles below into time */
+  uint32_t count;         /* interrupts handled */
+  uint32_t overruns;      /* periodic ones that waited a whole period */
+  uint32_t max_latency;   /* cycles from the expected assertion to entry */
+  uint32_t max_handler;   /* cycles from entry to EOI */
+  uint32_t latency[LATENCY_BUCKETS];
+  uint32_t handler[LATENCY_BUCKETS];
+} irq_stat_t;
+
+/* the bookkeeping of one irq line */
+typedef struct irq_latency {
+  irq_stat_t stat;
+  uint64_t entry;         /* TSC at handler entry, 0 once EOI is sent */
+  uint32_t clocks;        /* the period in clocks of clock_hz, 0 if aperiodic */
+  uint32_t clock_hz;
+  uint64_t period;        /* the period in TSC cycles, 0 until known */
+  uint64_t expected;      /* TSC the next assertion is expected at */
+  uint64_t window_min;    /* least latency seen in this window */
+  uint32_t window_count;
+  uint32_t windows;       /* windows seen, up to LATENCY_SETTLE */
+} irq_latency_t;
+
+void irq_latency_enter(uint32_t irq);
+
+void irq_latency_eoi(uint32_t irq);
+
+void irq_latency_period(uint32_t irq, uint32_t clocks, uint32_t clock_hz);
+
+int32_t irq_latency_read(uint32_t irq, irq_stat_t *buf);
+
+void irq_latency_reset(uint32_t irq);
+
+#endif
@@ -11,6 +11,8 @@
 static int screen_x;
 static int screen_y;
 static char *video_mem = (char *)VIDEO;
+// a second place every console character goes to, such as a serial port
+static void (*console_sink)(uint8_t c) = NULL;
 
 /* void clear(void);
  * Inputs: void
@@ -190,6 +192,9 @@ void putc(uint8_t c)
     //do nothing if the input is null, need a test for checking garbege
     if (c == NULL)
         return;
+    // mirror the console so headless runs can capture it
+    if (console_sink != NULL)
+        console_sink(c);
     //enter case
     if (c == '\n' || c == '\r')
     {
@@ -601,3 +606,34 @@ void set_y(int32_t y)
 {
     screen_y = y;
 }
+
+/* set_video_mem
+ * Inputs: addr -- the video memory or one of the terminal buffers
+ * Return Value: none
+ * Function: redirect the console output to the given page, so a terminal
+ * that is not shown writes into its buffer without touching the page table
+ */
+void set_video_mem(uint32_t addr)
+{
+    video_mem = (char *)addr;
+}
+
+/* get_video_mem
+ * Inputs: none
+ * Return Value: the page the console currently writes to
+ * Function: return the current console output page
+ */
+uint32_t get_video_mem()
+{
+    return (uint32_t)video_mem;
+}
+
+/* void set_console_sink(void (*sink)(uint8_t c));
+ * Inputs: sink = function every character passed to putc is also sent to,
+ *                NULL for none
+ * Return Value: none
+ * Function: Mirror the console output, used for the serial kernel log */
+void set_console_sink(void (*sink)(uint8_t c))
+{
+    console_sink = sink;
+}
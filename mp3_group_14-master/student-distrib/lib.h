@@ -39,6 +39,28 @@ int get_y();
 
 void set_x(int32_t x);
 void set_y(int32_t y);
+
+/* Helper functions for the video memory the console writes to */
+void set_video_mem(uint32_t addr);
+uint32_t get_video_mem();
+void set_console_sink(void (*sink)(uint8_t c));
+#ifdef HOST_BUILD
+
+/* The host harness in host/ runs this code as a Linux process, where port
+ * I/O and the interrupt flag are off limits and there is nothing to mask */
+#define inb(port)                       0
+#define inw(port)                       0
+#define inl(port)                       0
+#define outb(data, port)                do { } while (0)
+#define outw(data, port)                do { } while (0)
+#define outl(data, port)                do { } while (0)
+#define cli()                           do { } while (0)
+#define cli_and_save(flags)             do { (flags) = 0; } while (0)
+#define sti()                           do { } while (0)
+#define restore_flags(flags)            do { (void)(flags); } while (0)
+
+#else
+
 /* Port read functions */
 /* Inb reads a byte and returns its value as a zero-extended 32-bit
  * unsigned int */
@@ -164,4 +186,6 @@ do {                                    \
     );                                  \
 } while (0)
 
+#endif /* HOST_BUILD */
+
 #endif /* _LIB_H */
@@ -1,10 +1,29 @@
 #include "types.h"
 #include "paging.h"
+#include "smp.h"
+#include "spinlock.h"
 
 // align the pte and pde
 uint32_t pte[PTE_SIZE] __attribute__((aligned (PTE_ALIGN_SIZE)));
 uint32_t pde[PDE_SIZE] __attribute__((aligned (PDE_ALIGN_SIZE)));
 
+// one page directory per process, the kernel entries are copied from pde
+uint32_t process_pde[MAX_PROCESS_NUM][PDE_SIZE] __attribute__((aligned (PDE_ALIGN_SIZE)));
+
+// one page table per process for the user video memory mapped by vidmap
+uint32_t vid_pte[MAX_PROCESS_NUM][PTE_SIZE] __attribute__((aligned (PTE_ALIGN_SIZE)));
+
+// one page table per process for the read-only file mappings made by mmap
+uint32_t mmap_pte[MAX_PROCESS_NUM][PTE_SIZE] __attribute__((aligned (PTE_ALIGN_SIZE)));
+
+// one page table per process for the heap and the stack
+uint32_t data_pte[MAX_PROCESS_NUM][PTE_SIZE] __attribute__((aligned (PTE_ALIGN_SIZE)));
+
+// which 4KB frames of the frame pool are handed out
+static uint8_t frame_used[FRAME_NUM];
+// taken by sbrk, ring_setup and the page fault handler alike
+static spinlock_t frame_lock = SPINLOCK_INIT("frame");
+
 /*
  * init_paging
  * description:
@@ -40,11 +59,23 @@ void init_paging(){
   //for the kernel space, 4MB, supervisor, r/w, present
   pde[PDE_KER_INDEX] = KERNEL_MEM_ADDR | KERNEL_MEM_INDEX;   // should be 0x00400083;
 
+  //for the frame pool, 4MB, supervisor, r/w, present, so the kernel can clear frames
+  pde[FRAME_POOL_ADDR >> 22] = FRAME_POOL_ADDR | KERNEL_MEM_INDEX;
+
+  //for the program frames, 4MB each, supervisor, r/w, present, for the same reason
+  for (i = 0; i < MAX_PROCESS_NUM; i++)
+    pde[(PROGRAM_FRAME_ADDR + i * PROGRAM_FRAME_SIZE) >> PDE_SHIFT] =
+      (PROGRAM_FRAME_ADDR + i * PROGRAM_FRAME_SIZE) | KERNEL_MEM_INDEX;
+
+  //for the IOAPIC and local APIC registers, 4MB, supervisor, r/w, present, uncached
+  pde[APIC_MMIO_ADDR >> PDE_SHIFT] = APIC_MMIO_ADDR | KERNEL_MEM_INDEX | PAGE_PCD | PAGE_PWT;
+
   /*todo: init pde: setup ped for process use
   * approach: set up 8 pde and assign to processes (static pde start address)
   * approach: always map pde to 128 memory map
   */
-  //set, cr3, cr4, cr0
+  //set, cr3, cr4, cr0. cr0 turns on paging and write protect, so the
+  //kernel faults on the read-only user pages like the user does
   asm volatile("            \n\
     pushl %%eax             \n\
     movl $pde, %%eax        \n\
@@ -53,7 +84,7 @@ void init_paging(){
     orl $0x00000010, %%eax  \n\
     movl %%eax, %%cr4       \n\
     movl %%cr0, %%eax       \n\
-    orl $0x80000000, %%eax  \n\
+    orl $0x80010000, %%eax  \n\
     movl %%eax, %%cr0       \n\
     popl %%eax              "
     :          //no output
@@ -63,32 +94,72 @@ void init_paging(){
 }
 
 /*
- * reset_paging
- *   DESCRIPTION: open new page for process
- *   INPUTS: uint32_t physical_mem_ -- physical memory to reset
+ * init_process_paging
+ *   DESCRIPTION: build the page directory of a new process, the kernel
+ *                entries are shared by reference with the boot directory
+ *   INPUTS: uint32_t pid -- the process the directory belongs to
+ *           uint32_t physical_mem_ -- physical 4MB frame of the program
+ *   OUTPUTS: none
+ *   RETURN VALUE: the page directory of the process
+ *   SIDE EFFECTS: the old mappings of the pid are dropped
+ */
+uint32_t *init_process_paging(uint32_t pid, uint32_t physical_mem_){
+  int i;
+
+  // give back the heap and stack frames a killed process may have left
+  delete_user_data_pages(pid);
+
+  for (i = 0; i < PDE_SIZE; i++) {
+    process_pde[pid][i] = 0;
+    vid_pte[pid][i] = 0;
+  }
+
+  // everything below the program page belongs to the kernel
+  for (i = 0; i < PDE_POS; i++) {
+    process_pde[pid][i] = pde[i];
+  }
+
+  // the 128MB program page and the mmap region of this process
+  process_pde[pid][PDE_POS] = (physical_mem_ & PHYS_MASK) | SET_PAGE_087;
+  process_pde[pid][USER_MMAP_ADDR >> 22] = (uint32_t)mmap_pte[pid] | URW_MASK;
+  process_pde[pid][USER_HEAP_ADDR >> 22] = (uint32_t)data_pte[pid] | URW_MASK;
+  process_pde[pid][APIC_MMIO_ADDR >> PDE_SHIFT] = pde[APIC_MMIO_ADDR >> PDE_SHIFT];
+
+  return process_pde[pid];
+}
+
+/*
+ * load_page_directory
+ *   DESCRIPTION: switch to the address space of a process
+ *   INPUTS: uint32_t *page_directory -- the directory to load
  *   OUTPUTS: none
  *   RETURN VALUE: none
- *   SIDE EFFECTS: clear the TLB and reset the physical memory
+ *   SIDE EFFECTS: load cr3, which also flushes the TLB
  */
-void reset_paging(uint32_t physical_mem_){
-  pde[PDE_POS] = (physical_mem_ & PHYS_MASK) | SET_PAGE_087;
-  flush_tlb();
+void load_page_directory(uint32_t *page_directory){
+  asm volatile(
+    "movl %0, %%cr3"
+    :
+    : "r"(page_directory)
+    : "memory"
+  );
 }
 
 /*
  * reset_video_page
  *   DESCRIPTION: open new page for video memory 
- *   INPUTS: none
+ *   INPUTS: uint32_t pid -- the process that asked for vidmap
+ *           uint32_t addr -- the video memory or the terminal buffer
  *   OUTPUTS: none
  *   RETURN VALUE: none
  *   SIDE EFFECTS: retset the video memory and flush the TLB
  */
-void reset_video_page(uint32_t addr){
+void reset_video_page(uint32_t pid, uint32_t addr){
   // shift 22 bits to get the correct pde entry index
-  pde[USER_VID_MEM >> 22] = (uint32_t)pte | URW_MASK;
+  process_pde[pid][USER_VID_MEM >> 22] = (uint32_t)vid_pte[pid] | URW_MASK;
 
   //change to current index and flush TLB
-  pte[VID_MEM_INDEX] = addr | URW_MASK;
+  vid_pte[pid][VID_MEM_INDEX] = addr | URW_MASK;
   flush_tlb();
 
   return;
@@ -129,29 +200,234 @@ void set_pte(uint32_t index, uint32_t addr){
 }
 
 /*
- * get_old_pte
- *   DESCRIPTION: get the current video memory
+ * delete_user_video_page
+ *   DESCRIPTION: delete user video page
+ *   INPUTS: uint32_t pid -- the process that is halting
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush TLB
+ */
+void delete_user_video_page(uint32_t pid){
+  // shift 22 bits to get the correct pde entry index, set the pde not exit (0)
+  process_pde[pid][USER_VID_MEM >> 22] = 0;
+  vid_pte[pid][VID_MEM_INDEX] = 0;
+  flush_tlb();
+}
+
+/*
+ * map_user_ring_page
+ *   DESCRIPTION: back the io ring page of a process with a new frame, it
+ *                shares the page table of the user video memory
+ *   INPUTS: uint32_t pid -- the process that asked for a ring
+ *   OUTPUTS: none
+ *   RETURN VALUE: physical address of the frame, 0 if no frame is left
+ *   SIDE EFFECTS: flush the TLB
+ */
+uint32_t map_user_ring_page(uint32_t pid){
+  uint32_t frame;
+
+  if (vid_pte[pid][RING_INDEX] & PAGE_PRESENT) return vid_pte[pid][RING_INDEX] & PHYS_MASK;
+  if ((frame = alloc_frame()) == 0) return 0;
+
+  // shift 22 bits to get the correct pde entry index
+  process_pde[pid][USER_VID_MEM >> 22] = (uint32_t)vid_pte[pid] | URW_MASK;
+  vid_pte[pid][RING_INDEX] = frame | URW_MASK;
+  flush_tlb();
+  return frame;
+}
+
+/*
+ * delete_user_ring_page
+ *   DESCRIPTION: drop the io ring page of a process and free its frame
+ *   INPUTS: uint32_t pid -- the process that is halting
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void delete_user_ring_page(uint32_t pid){
+  if (!(vid_pte[pid][RING_INDEX] & PAGE_PRESENT)) return;
+  free_frame(vid_pte[pid][RING_INDEX] & PHYS_MASK);
+  vid_pte[pid][RING_INDEX] = 0;
+  flush_tlb();
+}
+
+/*
+ * map_user_vdso_page
+ *   DESCRIPTION: map the vdso page of a process read-only, it shares the
+ *                page table of the user video memory
+ *   INPUTS: uint32_t pid -- the process being loaded
+ *           uint32_t addr -- the kernel page that holds its vdso data
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void map_user_vdso_page(uint32_t pid, uint32_t addr){
+  // shift 22 bits to get the correct pde entry index
+  process_pde[pid][USER_VID_MEM >> 22] = (uint32_t)vid_pte[pid] | URW_MASK;
+  vid_pte[pid][VDSO_INDEX] = (addr & PHYS_MASK) | UR_MASK;
+  flush_tlb();
+}
+
+/*
+ * set_mmap_pte
+ *   DESCRIPTION: map one 4KB page of the process's mmap region read-only
+ *   INPUTS: pid -- the process that owns the mapping
+ *           index -- the page index inside the mmap region
+ *           addr -- the physical address of the file data block
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none, the caller flushes the TLB once all pages are set
+ */
+void set_mmap_pte(uint32_t pid, uint32_t index, uint32_t addr){
+  mmap_pte[pid][index] = (addr & PHYS_MASK) | UR_MASK;
+}
+
+/*
+ * delete_mmap_page
+ *   DESCRIPTION: drop all file mappings of the given process
+ *   INPUTS: pid -- the process that is halting
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void delete_mmap_page(uint32_t pid){
+  int i;
+  for (i = 0; i < PTE_SIZE; i++) {
+    mmap_pte[pid][i] = 0;
+  }
+  flush_tlb();
+}
+
+/*
+ * alloc_frame
+ *   DESCRIPTION: take a free 4KB frame from the frame pool
  *   INPUTS: none
  *   OUTPUTS: none
- *   RETURN VALUE: the current video memory
+ *   RETURN VALUE: physical address of the frame, 0 if the pool is empty
+ *   SIDE EFFECTS: the frame is cleared so no data leaks between processes
+ */
+uint32_t alloc_frame(void){
+  int i;
+  uint32_t addr, flags;
+
+  flags = spin_lock_irqsave(&frame_lock);
+  for (i = 0; i < FRAME_NUM; i++) {
+    if (frame_used[i] == 0) {
+      frame_used[i] = 1;
+      spin_unlock_irqrestore(&frame_lock, flags);
+      // the frame is ours now, clear it outside the lock
+      addr = FRAME_POOL_ADDR + i * _4KB;
+      memset((void *)addr, 0, _4KB);
+      return addr;
+    }
+  }
+  spin_unlock_irqrestore(&frame_lock, flags);
+  return 0;
+}
+
+/*
+ * free_frame
+ *   DESCRIPTION: give a 4KB frame back to the frame pool
+ *   INPUTS: uint32_t addr -- physical address of the frame
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
  *   SIDE EFFECTS: none
  */
-uint32_t get_old_pte(void) {
-  return pte[VID_MEM_INDEX];
+void free_frame(uint32_t addr){
+  uint32_t flags;
+
+  if (addr < FRAME_POOL_ADDR || addr >= FRAME_POOL_ADDR + FRAME_NUM * _4KB) return;
+  flags = spin_lock_irqsave(&frame_lock);
+  frame_used[(addr - FRAME_POOL_ADDR) / _4KB] = 0;
+  spin_unlock_irqrestore(&frame_lock, flags);
 }
 
 /*
- * delete_user_video_page
- *   DESCRIPTION: delete user video page
- *   INPUTS: none
+ * map_user_data_page
+ *   DESCRIPTION: back one heap or stack page of a process with a new frame
+ *   INPUTS: uint32_t pid -- the process
+ *           uint32_t addr -- a virtual address inside the page
  *   OUTPUTS: none
- *   RETURN VALUE: the current video memory
- *   SIDE EFFECTS: flush TLB
+ *   RETURN VALUE: 0 for success, -1 if no frame is left
+ *   SIDE EFFECTS: flush the TLB
  */
-void delete_user_video_page(){
-  // shift 22 bits to get the correct pde entry index, set the pde not exit (0)
-  pde[USER_VID_MEM >> 22] = 0;
+int32_t map_user_data_page(uint32_t pid, uint32_t addr){
+  uint32_t index = ((addr - USER_HEAP_ADDR) >> 12) & (PTE_SIZE - 1);
+  uint32_t frame;
+
+  if (data_pte[pid][index] & PAGE_PRESENT) return 0;
+  if ((frame = alloc_frame()) == 0) return -1;
+
+  data_pte[pid][index] = frame | URW_MASK;
+  flush_tlb();
+  return 0;
+}
+
+/*
+ * unmap_user_data_page
+ *   DESCRIPTION: drop one heap or stack page of a process
+ *   INPUTS: uint32_t pid -- the process
+ *           uint32_t addr -- a virtual address inside the page
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void unmap_user_data_page(uint32_t pid, uint32_t addr){
+  uint32_t index = ((addr - USER_HEAP_ADDR) >> 12) & (PTE_SIZE - 1);
+
+  if (!(data_pte[pid][index] & PAGE_PRESENT)) return;
+  free_frame(data_pte[pid][index] & PHYS_MASK);
+  data_pte[pid][index] = 0;
+  flush_tlb();
+}
+
+/*
+ * delete_user_data_pages
+ *   DESCRIPTION: drop the whole heap and stack of a process
+ *   INPUTS: uint32_t pid -- the process that is halting
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void delete_user_data_pages(uint32_t pid){
+  int i;
+  for (i = 0; i < PTE_SIZE; i++) {
+    if (data_pte[pid][i] & PAGE_PRESENT) {
+      free_frame(data_pte[pid][i] & PHYS_MASK);
+    }
+    data_pte[pid][i] = 0;
+  }
   flush_tlb();
 }
 
+/*
+ * grow_user_stack
+ *   DESCRIPTION: called on a page fault, map the stack down to the faulting
+ *                address if it lies between the guard page above the heap
+ *                and the current bottom of the stack
+ *   INPUTS: uint32_t addr -- the faulting address from cr2
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 if the fault was a stack growth, -1 otherwise
+ *   SIDE EFFECTS: flush the TLB
+ */
+int32_t grow_user_stack(uint32_t addr){
+  uint32_t page, stack_limit;
+  pcb_t *pcb = get_pcb();
+
+  // only faults taken on a process kernel stack belong to a process
+  if ((uint32_t)pcb < (uint32_t)get_pcb_by_pid(MAX_PCB) || (uint32_t)pcb > (uint32_t)get_pcb_by_pid(0))
+    return -1;
+  // a thread made by clone grows the stack of its program
+  pcb = get_mm_pcb();
 
+  // keep one unmapped guard page between the heap and the stack
+  stack_limit = PAGE_ROUND_UP(pcb->heap_break) + _4KB;
+  if (stack_limit < USER_STACK_TOP - USER_STACK_MAX) stack_limit = USER_STACK_TOP - USER_STACK_MAX;
+  if (addr < stack_limit || addr >= pcb->stack_bottom) return -1;
+
+  for (page = addr & PHYS_MASK; page < pcb->stack_bottom; page += _4KB) {
+    if (map_user_data_page(pcb->pid, page) == -1) return -1;
+  }
+  pcb->stack_bottom = addr & PHYS_MASK;
+  return 0;
+}
@@ -32,6 +32,35 @@
 #define PHYS_MASK             0XFFFFF000
 #define SET_PAGE_087          0x087
 #define USER_VID_MEM          0x084B8000
+#define USER_MMAP_ADDR        0x08800000
+#define UR_MASK               0x05
+
+// the io ring page shares the page table of vidmap, above the video page
+#define USER_RING_ADDR        0x084C0000
+#define RING_INDEX            0xC0
+// so does the read-only vdso page
+#define USER_VDSO_ADDR        0x084C1000
+#define VDSO_INDEX            0xC1
+
+// the 4MB program frame of each pid, mapped for the kernel only as well
+// so the zeroer can clear them
+#define PROGRAM_FRAME_ADDR    0x00800000
+#define PROGRAM_FRAME_SIZE    0x00400000
+
+// 4KB frames for user heap and stack pages, mapped for the kernel only
+#define FRAME_POOL_ADDR       0x02000000
+#define FRAME_NUM             1024
+#define PAGE_PRESENT          0x01
+
+// device registers must not be cached
+#define PAGE_PWT              0x08
+#define PAGE_PCD              0x10
+
+// heap grows up from USER_HEAP_ADDR, stack grows down from USER_STACK_TOP
+#define USER_HEAP_ADDR        0x08C00000
+#define USER_STACK_TOP        0x09000000
+#define USER_STACK_MAX        0x00100000
+#define PAGE_ROUND_UP(addr)   (((addr) + _4KB - 1) & PHYS_MASK)
 
 #define ADDR_OFFSET           4
 #define IRQ_ZERO              0
@@ -40,16 +69,38 @@
 // define the initialization function
 void init_paging();
 
-void reset_paging(uint32_t physical_mem_ );
+uint32_t *init_process_paging(uint32_t pid, uint32_t physical_mem_);
 
-void reset_video_page(uint32_t addr);
+void load_page_directory(uint32_t *page_directory);
+
+void reset_video_page(uint32_t pid, uint32_t addr);
 
 void flush_tlb(void);
 
 void set_pte(uint32_t index, uint32_t addr);
 
-uint32_t get_old_pte(void);
+void delete_user_video_page(uint32_t pid);
+
+uint32_t map_user_ring_page(uint32_t pid);
+
+void delete_user_ring_page(uint32_t pid);
+
+void map_user_vdso_page(uint32_t pid, uint32_t addr);
+
+void set_mmap_pte(uint32_t pid, uint32_t index, uint32_t addr);
+
+void delete_mmap_page(uint32_t pid);
+
+uint32_t alloc_frame(void);
+
+void free_frame(uint32_t addr);
+
+int32_t map_user_data_page(uint32_t pid, uint32_t addr);
+
+void unmap_user_data_page(uint32_t pid, uint32_t addr);
+
+void delete_user_data_pages(uint32_t pid);
 
-void delete_user_video_page();
+int32_t grow_user_stack(uint32_t addr);
 
 #endif
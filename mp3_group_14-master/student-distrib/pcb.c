@@ -16,8 +16,8 @@ int32_t err_func(int32_t fd, uint8_t *buf, int32_t length)
 }
 
 /* function pointers of stdin and stdout */
-func_ptr stdin_funcs[4] = {terminal_read, err_func, terminal_open, terminal_close};
-func_ptr stdout_funcs[4] = {err_func, terminal_write, terminal_open, terminal_close};
+func_ptr stdin_funcs[FUNCTION_PTR_SIZE] = {terminal_read, err_func, terminal_open, terminal_close, terminal_poll};
+func_ptr stdout_funcs[FUNCTION_PTR_SIZE] = {err_func, terminal_write, terminal_open, terminal_close, terminal_poll};
 
 /*
  * get_pcb
@@ -41,6 +41,34 @@ pcb_t *get_pcb()
   return ret;
 }
 
+/*
+ * get_pcb_by_pid
+ *   DESCRIPTION: return the pcb of the given process
+ *   INPUTS: pid -- the process id
+ *   OUTPUTS: none
+ *   RETURN VALUE: pcb pointer of the process
+ *   SIDE EFFECTS: none
+ */
+pcb_t *get_pcb_by_pid(uint32_t pid)
+{
+  return (pcb_t *)(PCB_BASE + (MAX_PCB - pid) * _8KB);
+}
+
+/*
+ * get_mm_pcb
+ *   DESCRIPTION: return the pcb of the program whose address space the
+ *                current process runs in, that of the program for a thread
+ *                made by clone
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: pcb pointer holding the heap and the mappings
+ *   SIDE EFFECTS: none
+ */
+pcb_t *get_mm_pcb()
+{
+  return get_pcb_by_pid(get_pcb()->tgid);
+}
+
 /*
 * pcb_init
 * description: setup pcb structure for process
@@ -61,11 +89,30 @@ void pcb_init(pcb_t *pcb, int32_t next_pid)
   }
   //set descriptor[0], [1] to stdin stdout
   pcb->descriptors[0].f_flag = INUSE;
+  pcb->descriptors[0].f_status = 0;
   pcb->descriptors[0].file_operations_table_ptr = stdin_funcs;
   pcb->descriptors[1].f_flag = INUSE;
+  pcb->descriptors[1].f_status = 0;
   pcb->descriptors[1].file_operations_table_ptr = stdout_funcs;
   for (i = 2; i < 8; i++)
   {
     pcb->descriptors[i].f_flag = UNUSE;
+    pcb->descriptors[i].f_status = 0;
+  }
+  pcb->mmap_pages = 0;
+  pcb->terminal_id = get_current_running_terminal();
+  pcb->vid_mapped = LOW;
+  for (i = 0; i < NUM_SIGNALS; i++)
+  {
+    pcb->sig_handlers[i] = NULL;
   }
+  pcb->sig_pending = 0;
+  pcb->sig_masked = 0;
+  memset(&pcb->acct, 0, sizeof(proc_account_t));
+  pcb->tgid = next_pid;
+  pcb->clear_tid = 0;
+  pcb->futex_addr = 0;
+  pcb->thread_frame = NULL;
+  pcb->thread_dead = 0;
+  pcb->sched_waiting = 0;
 }
@@ -5,6 +5,9 @@
 #include "file_system.h"
 #include "keyboard.h"
 #include "do_sys.h"
+#include "signal.h"
+#include "fcntl.h"
+#include "account.h"
 
 #define PCB_MASK        0xFFFFE000  /* something */
 /*0x800000 -> 0x796000 is left for 8 pcb to use */
@@ -16,6 +19,8 @@
 #define INUSE 1
 #define UNUSE 0
 #define USER_VID_MEM 0x084B8000
+// a file name of the file system, the longest program name
+#define PROCESS_NAME_LEN 32
 
 typedef int32_t (*func_ptr)();
 /* (pcb_ptr ++) give address of next pcb */
@@ -27,6 +32,8 @@ typedef struct file_descriptor{
   struct inode_t * f_inode;
   uint32_t f_file_position;
   uint32_t f_flag;
+  /* O_NONBLOCK, set with fcntl */
+  uint32_t f_status;
 } fd_t;
 
 typedef struct pcb_struct {
@@ -38,6 +45,42 @@ typedef struct pcb_struct {
   int32_t             parent_ebp;           
   int32_t             parent_esp;              
   int32_t             parent_esp0;
+  // number of 4KB pages already handed out in the mmap region
+  uint32_t            mmap_pages;
+  // the terminal the process runs on and whether it called vidmap
+  uint32_t            terminal_id;
+  uint32_t            vid_mapped;
+  // private address space, loaded into cr3 on every switch
+  uint32_t *          page_directory;
+  // end of the heap and lowest mapped stack page
+  uint32_t            heap_break;
+  uint32_t            stack_bottom;
+  // user signal handlers, NULL for the default action
+  void *              sig_handlers[NUM_SIGNALS];
+  // signals waiting for the return to user space, and those held back
+  uint32_t            sig_pending;
+  uint32_t            sig_masked;
+  // the name the program was executed as
+  int8_t              name[PROCESS_NAME_LEN + 1];
+  // cpu ticks, switches, system calls and page faults, see account.c
+  proc_account_t      acct;
+  // the program a thread made by clone belongs to, its own pid otherwise.
+  // The heap, the mmap region and the mappings are in that pcb
+  uint32_t            tgid;
+  // the tid word cleared when the thread halts, 0 for none
+  uint32_t            clear_tid;
+  // the user word the task sleeps on in futex_wait, 0 otherwise
+  uint32_t            futex_addr;
+  // a new thread leaves for user space with this frame, see thread.c
+  void *              thread_frame;
+  // a halted thread, its pid is freed once the scheduler leaves it
+  uint32_t            thread_dead;
+  // kernel esp, ebp, esp0 and waiting flag of a thread while another one
+  // of its program has the terminal
+  uint32_t            sched_esp;
+  uint32_t            sched_ebp;
+  uint32_t            sched_esp0;
+  int32_t             sched_waiting;
 } pcb_t ;
 
 /* create 8kb structure use to traverse avaliable pcb in kernel space */
@@ -51,4 +94,8 @@ void pcb_init(pcb_t * pcb, int32_t next_pid);
 
 pcb_t* get_pcb();
 
+pcb_t* get_pcb_by_pid(uint32_t pid);
+
+pcb_t* get_mm_pcb();
+
 #endif
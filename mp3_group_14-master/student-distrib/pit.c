@@ -4,6 +4,32 @@
 //set pit to mode 3 with 100 HZ
 static int count = 0;
 
+// PIT clocks programmed for the running one-shot, 0 in periodic mode
+static uint32_t oneshot_clocks = 0;
+// PIT clocks that are not worth a whole 100HZ tick yet
+static uint32_t clock_remainder = 0;
+
+/*
+ * pit_account
+ * description:
+ * turn elapsed PIT clocks into 100HZ ticks for the timers
+ * input: clocks -- PIT clocks since the last call
+ * output: none
+ */
+static void pit_account(uint32_t clocks)
+{
+    uint32_t ticks;
+
+    clock_remainder += clocks;
+    ticks = clock_remainder / _100HZ;
+    clock_remainder %= _100HZ;
+    if (ticks != 0)
+    {
+        alarm_tick(ticks);
+        vdso_tick(ticks);
+    }
+}
+
 /*
  * pit_init
  * description:
@@ -14,15 +40,87 @@ static int count = 0;
 void pit_init()
 {
     //mode 3
-    outb(MODE_3, PIT_COMMAND);
-    //high_byte, use 0xFF to mask out the low bytes
-    outb(_100HZ & 0xFF, CHANNEL_0);
-    //low byte
-    outb(_100HZ >> 8, CHANNEL_0);
+    pit_set_periodic();
     //pit the 0th interrupt
     enable_irq(0);
 }
 
+/*
+ * pit_set_periodic
+ * description:
+ * program the PIT to interrupt at 100HZ
+ * input: none
+ * output: none
+ */
+void pit_set_periodic()
+{
+    //mode 3
+    outb(MODE_3, PIT_COMMAND);
+    //low byte, use 0xFF to mask out the high byte
+    outb(_100HZ & BYTE_MASK, CHANNEL_0);
+    //high byte
+    outb(_100HZ >> BYTE_SHIFT, CHANNEL_0);
+    oneshot_clocks = 0;
+    irq_latency_period(IRQ_ZERO, _100HZ, PIT_FREQ);
+}
+
+/*
+ * pit_set_oneshot
+ * description:
+ * program a single PIT interrupt after the given number of clocks, used
+ * when nothing is runnable so the cpu is not woken 100 times a second
+ * input: clocks -- PIT clocks until the interrupt, capped at PIT_MAX_COUNT
+ * output: none
+ */
+void pit_set_oneshot(uint32_t clocks)
+{
+    if (clocks == 0) clocks = 1;
+    if (clocks > PIT_MAX_COUNT) clocks = PIT_MAX_COUNT;
+    //mode 0
+    outb(MODE_0, PIT_COMMAND);
+    outb(clocks & BYTE_MASK, CHANNEL_0);
+    outb(clocks >> BYTE_SHIFT, CHANNEL_0);
+    oneshot_clocks = clocks;
+    // a one-shot has no period to be late against
+    irq_latency_period(IRQ_ZERO, 0, PIT_FREQ);
+}
+
+/*
+ * pit_kick
+ * description:
+ * called when a waiting process becomes runnable, leave one-shot mode and
+ * account for the part of the one-shot that has elapsed. A one-shot that
+ * already fired is left to pit_handler
+ * input: none
+ * output: none
+ */
+void pit_kick()
+{
+    uint32_t flags, status, left;
+
+    cli_and_save(flags);
+    if (oneshot_clocks != 0)
+    {
+        // latch the status and the count left together, the status first
+        outb(READ_BACK_CH0, PIT_COMMAND);
+        status = inb(CHANNEL_0);
+        left = inb(CHANNEL_0);
+        left |= inb(CHANNEL_0) << BYTE_SHIFT;
+        // OUT is high once the one-shot fired, the count has wrapped since
+        // and says nothing. Its interrupt is still pending, leave
+        // oneshot_clocks set so pit_handler accounts the whole one-shot and
+        // goes periodic itself
+        if (!(status & STATUS_OUT))
+        {
+            // a count not loaded yet reads back as anything
+            if (left > oneshot_clocks) left = oneshot_clocks;
+            pit_account(oneshot_clocks - left);
+            pit_set_periodic();
+        }
+    }
+    restore_flags(flags);
+}
+
 /*
  * pit_handler
  * description:
@@ -32,50 +130,145 @@ void pit_init()
  * - set TSS
  * - update the x, y coordinates
  * - restore esp/ebp
+ * a kernel thread with work runs for a tick as the round robin wraps
+ * from the last terminal to the first, and for as long as every
+ * terminal waits
  * input: none
  * output: none
  */
 void pit_handler()
 {
     int32_t vid_buffer_addr;
+    int32_t was_oneshot;
+    uint32_t clocks;
+    int32_t knext = KTHREAD_NONE;
+    int32_t from, rotated;
+    void *frame;
 
     //get current and next running terminal
     int32_t current = get_current_running_terminal();
     int32_t current_looking = get_current_looking_terminal();
+    // while a kernel thread runs, current is the terminal it came from
+    int32_t kthread = kthread_current();
     
-    //calculate the next terminal id
+    // save the current pid
+    if (kthread == KTHREAD_NONE)
+        terminals[current].current_pid =  get_pcb()->pid;
+
+    // advance the timers by the time since the last interrupt, a one-shot
+    // has fired in full so a wakeup must not account it again
+    was_oneshot = (oneshot_clocks != 0);
+    pit_account(was_oneshot ? oneshot_clocks : _100HZ);
+    oneshot_clocks = 0;
+    timer_expire();
+
+    // charge the tick to the process or kernel thread it interrupted, a
+    // one-shot or a wait in hlt is idle time. Before the first shell there
+    // is no process
+    if (count > 0 && !was_oneshot &&
+        (kthread == KTHREAD_NONE ? terminals[current].waiting == NO : kthread_runnable(kthread)))
+        account_tick();
+
+    // inside a lock or a program load, only keep time and switch next tick
+    if (preempt_disabled())
+    {
+        if (was_oneshot)
+            pit_set_periodic();
+        send_eoi(IRQ_ZERO);
+        return;
+    }
+
+    //calculate the next terminal id, terminals waiting in idle_wait are skipped
     int32_t next = current + 1;
     next = next % MAX_TERM;
+    if (count >= 3)
+        next = next_runnable_terminal(current);
+
+    // a kernel thread gets its turn as the round robin wraps
+    if (count >= 3 && kthread == KTHREAD_NONE && next <= current)
+        knext = kthread_pick();
+
+    // with nothing runnable, sleep until the next deadline instead of ticking
+    if (count >= 3 && all_terminals_waiting() && knext == KTHREAD_NONE && !kthread_runnable(kthread))
+    {
+        clocks = alarm_ticks_left() * _100HZ - clock_remainder;
+        if (timer_clocks_left() < clocks)
+            clocks = timer_clocks_left();
+        pit_set_oneshot(clocks);
+    }
+    else if (was_oneshot)
+    {
+        pit_set_periodic();
+    }
+
+    // a kernel thread with work keeps going while every terminal waits
+    if (kthread_runnable(kthread) && all_terminals_waiting())
+    {
+        send_eoi(IRQ_ZERO);
+        return;
+    }
+
+    // switch from the process of the terminal to a kernel thread, the
+    // address space, the TSS and the console stay those of the terminal
+    if (knext != KTHREAD_NONE)
+    {
+        asm volatile(
+            "movl %%esp,%0 \n"
+            "movl %%ebp,%1 \n"
+            : "=g"(terminals[current].saved_esp), "=g"(terminals[current].saved_ebp)
+            :
+            : "memory");
+        terminals[current].esp0 = tss.esp0;
+        trace_event(TRACE_SWITCH, (terminals[current].current_pid << 16) | (KTHREAD_PID_BASE + knext));
+        kthread_enter(knext);
+        send_eoi(IRQ_ZERO);
+        if (!kthreads[knext].started)
+            kthread_start(knext); //never comes back
+        asm volatile(
+            "movl %0,%%esp \n"
+            "movl %1,%%ebp \n"
+            :
+            : "g"(kthreads[knext].saved_esp), "g"(kthreads[knext].saved_ebp));
+        return;
+    }
     
     // update the x, y coordinates
     set_x(terminals[next].x_pos);
     set_y(terminals[next].y_pos);
-    
-    // save the current pid
-    terminals[current].current_pid =  get_pcb()->pid;
 
-    //save esp and ebp
-    asm volatile(
-        "movl %%esp,%0 \n"
-        "movl %%ebp,%1 \n"
-        : "=g"(terminals[current].saved_esp), "=g"(terminals[current].saved_ebp)
-        :
-        : "memory");
-        
-    //store esp0;
-    terminals[get_current_running_terminal()].esp0 = tss.esp0;
+    //save esp and ebp, of the kernel thread if one is running
+    if (kthread != KTHREAD_NONE)
+    {
+        asm volatile(
+            "movl %%esp,%0 \n"
+            "movl %%ebp,%1 \n"
+            : "=g"(kthreads[kthread].saved_esp), "=g"(kthreads[kthread].saved_ebp)
+            :
+            : "memory");
+        kthread_enter(KTHREAD_NONE);
+    }
+    else
+    {
+        asm volatile(
+            "movl %%esp,%0 \n"
+            "movl %%ebp,%1 \n"
+            : "=g"(terminals[current].saved_esp), "=g"(terminals[current].saved_ebp)
+            :
+            : "memory");
 
-    // map the pte to the correct address
+        //store esp0;
+        terminals[get_current_running_terminal()].esp0 = tss.esp0;
+    }
+
+    // direct the console output to the screen or to the terminal buffer
     if (current_looking != next)
     {
         vid_buffer_addr = VID_MEM_BUFFER1 + next * _4KB;
-        set_pte(VID_MEM_INDEX, vid_buffer_addr);
-        flush_tlb();
+        set_video_mem(vid_buffer_addr);
     }
     else
     {
-        set_pte(VID_MEM_INDEX, VID_MEM_ADDR);
-        flush_tlb();
+        set_video_mem(VID_MEM_ADDR);
     }
 
     // update the next running terminal
@@ -101,17 +294,17 @@ void pit_handler()
         execute((uint8_t *)"shell"); //never comes back
     }
 
-    // reset paging
-    reset_paging(_8MB + _4MB * terminals[get_current_running_terminal()].current_pid);
+    // the threads of a program take turns at the slot of its terminal
+    from = (kthread != KTHREAD_NONE) ? KTHREAD_PID_BASE + kthread : terminals[current].current_pid;
+    rotated = thread_rotate(next);
 
-    // check is reset video paging is needed
-    if(terminals[get_current_running_terminal()].user_vid_mem == HIGH){
-        if(get_current_running_terminal() == get_current_looking_terminal()){
-            reset_video_page(VID_MEM_ADDR);
-        }else{
-            reset_video_page(VID_MEM_BUFFER1 + _4KB * get_current_running_terminal());
-        }
-    }
+    // trace the switch between the processes of the two terminals
+    trace_event(TRACE_SWITCH, (from << 16) | terminals[next].current_pid);
+    if (next != current || kthread != KTHREAD_NONE || rotated)
+        account_switch(terminals[next].current_pid);
+
+    // switch the address space, a single cr3 load
+    load_page_directory(get_pcb_by_pid(terminals[get_current_running_terminal()].current_pid)->page_directory);
 
     // reload tss.esp0
     tss.esp0 = terminals[get_current_running_terminal()].esp0;
@@ -119,6 +312,15 @@ void pit_handler()
     // send EOI to interrupt 0
     send_eoi(IRQ_ZERO);
 
+    // a thread that never ran goes straight to user space
+    if ((frame = thread_take_frame(terminals[next].current_pid)) != NULL)
+        asm volatile(
+            "movl %0,%%esp \n"
+            "jmp interrupt_return"
+            :
+            : "r"(frame)
+            : "memory"); //never comes back
+
     // stack switch, change esp, ebp
     asm volatile(
         "movl %0,%%esp \n"
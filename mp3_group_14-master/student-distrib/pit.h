@@ -8,18 +8,42 @@
 #include "pcb.h"
 #include "do_sys.h"
 #include "schedule.h"
+#include "signal.h"
+#include "clock.h"
+#include "trace.h"
+#include "latency.h"
+#include "vdso.h"
+#include "account.h"
+#include "kthread.h"
+#include "thread.h"
 
 #define MODE_3          0x36
 #define PIT_COMMAND     0x43
 #define _100            100
 #define PIT_FREQ        1193180
-#define _100HZ           PIT_FREQ / _100
+#define _100HZ          (PIT_FREQ / _100)
 #define CHANNEL_0       0x40
 #define MAX_TERM        3
 
+// one-shot mode for tickless idle, interrupt on terminal count
+#define MODE_0          0x30
+// read-back of channel 0, latching its status and count at the same time
+#define READ_BACK_CH0   0xC2
+// the OUT pin in the status byte, set once a one-shot reached 0
+#define STATUS_OUT      0x80
+#define PIT_MAX_COUNT   0xFFFF
+#define BYTE_MASK       0xFF
+#define BYTE_SHIFT      8
+
 void pit_init();
 
 void pit_handler();
 
+void pit_set_periodic();
+
+void pit_set_oneshot(uint32_t clocks);
+
+void pit_kick();
+
 
 #endif
@@ -0,0 +1,21 @@
+#ifndef POLL_H
+#define POLL_H
+
+#include "types.h"
+
+// events of a pollfd, what the poll entry of a file's jump table returns
+#define POLLIN              0x0001  /* a read would not block */
+#define POLLOUT             0x0004  /* a write would not block */
+#define POLLNVAL            0x0020  /* the descriptor is not open */
+
+// the entry of the file jump tables after read, write, open and close
+#define POLL_FUNC           4
+
+/* one descriptor of the poll system call */
+typedef struct pollfd {
+  int32_t fd;
+  int16_t events;
+  int16_t revents;
+} pollfd_t;
+
+#endif
@@ -0,0 +1,196 @@
+#include "prezero.h"
+#include "lib.h"
+#include "clock.h"
+#include "serial.h"
+#include "paging.h"
+#include "do_sys.h"
+#include "spinlock.h"
+#include "workqueue.h"
+
+// held while a frame changes state and for every chunk the zeroer clears,
+// so execute never finds a frame half way through a chunk
+static spinlock_t prezero_lock = SPINLOCK_INIT("prezero");
+static volatile uint32_t frame_state[MAX_PROCESS_NUM];
+static exec_stat_t exec_stat;
+
+static void prezero_work(work_t *work);
+static work_t prezero_item = WORK_INIT(prezero_work);
+
+/*
+ * prezero_frame
+ *   DESCRIPTION: the kernel address of the program frame of a pid
+ *   INPUTS: uint32_t pid -- the pid
+ *   OUTPUTS: none
+ *   RETURN VALUE: the frame, mapped by init_paging
+ *   SIDE EFFECTS: none
+ */
+static uint8_t *prezero_frame(uint32_t pid)
+{
+  return (uint8_t *)(PROGRAM_FRAME_ADDR + pid * PROGRAM_FRAME_SIZE);
+}
+
+/*
+ * prezero_work
+ *   DESCRIPTION: run by a worker thread, clear every dirty frame a chunk
+ *                at a time. A frame execute claims in between is left to
+ *                execute
+ *   INPUTS: work_t *work -- not used
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+static void prezero_work(work_t *work)
+{
+  uint32_t pid, offset;
+
+  for (pid = 0; pid < MAX_PROCESS_NUM; pid++)
+  {
+    spin_lock(&prezero_lock);
+    if (frame_state[pid] != FRAME_DIRTY)
+    {
+      spin_unlock(&prezero_lock);
+      continue;
+    }
+    frame_state[pid] = FRAME_ZEROING;
+    spin_unlock(&prezero_lock);
+
+    for (offset = 0; offset < PROGRAM_FRAME_SIZE; offset += PREZERO_CHUNK)
+    {
+      spin_lock(&prezero_lock);
+      if (frame_state[pid] != FRAME_ZEROING)
+      {
+        spin_unlock(&prezero_lock);
+        break;
+      }
+      memset(prezero_frame(pid) + offset, 0, PREZERO_CHUNK);
+      spin_unlock(&prezero_lock);
+    }
+
+    spin_lock(&prezero_lock);
+    if (frame_state[pid] == FRAME_ZEROING)
+      frame_state[pid] = FRAME_CLEAN;
+    spin_unlock(&prezero_lock);
+  }
+}
+
+/*
+ * prezero_init
+ *   DESCRIPTION: nothing is known about the frames at boot, have the
+ *                workers clear them once they run
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void prezero_init()
+{
+  uint32_t pid;
+
+  for (pid = 0; pid < MAX_PROCESS_NUM; pid++)
+    frame_state[pid] = FRAME_DIRTY;
+  queue_work(&prezero_item);
+}
+
+/*
+ * prezero_claim
+ *   DESCRIPTION: called by execute before it loads a program into the
+ *                frame of its pid. A frame the zeroer has not finished is
+ *                cleared here, which execute then pays for
+ *   INPUTS: uint32_t pid -- the new process
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the frame is all zero and in use
+ */
+void prezero_claim(uint32_t pid)
+{
+  uint32_t state;
+  uint64_t start;
+
+  if (pid >= MAX_PROCESS_NUM) return;
+
+  spin_lock(&prezero_lock);
+  state = frame_state[pid];
+  frame_state[pid] = FRAME_IN_USE;
+  spin_unlock(&prezero_lock);
+
+  if (state == FRAME_CLEAN)
+  {
+    exec_stat.clean++;
+    return;
+  }
+  start = rdtsc();
+  memset(prezero_frame(pid), 0, PROGRAM_FRAME_SIZE);
+  exec_stat.zero_cycles += rdtsc() - start;
+}
+
+/*
+ * prezero_release
+ *   DESCRIPTION: called by halt once a process is done with its frame,
+ *                hand the frame to the zeroer
+ *   INPUTS: uint32_t pid -- the halting process
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: wakes a worker thread
+ */
+void prezero_release(uint32_t pid)
+{
+  if (pid >= MAX_PROCESS_NUM) return;
+
+  spin_lock(&prezero_lock);
+  frame_state[pid] = FRAME_DIRTY;
+  spin_unlock(&prezero_lock);
+  // already queued is fine, the queued run checks every frame
+  queue_work(&prezero_item);
+}
+
+/*
+ * exec_latency_record
+ *   DESCRIPTION: called by execute right before it enters the program
+ *   INPUTS: uint64_t cycles -- TSC cycles since execute was called
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void exec_latency_record(uint64_t cycles)
+{
+  exec_stat.count++;
+  exec_stat.total_cycles += cycles;
+  if (cycles > 0xFFFFFFFF) cycles = 0xFFFFFFFF;
+  if (cycles > exec_stat.max_cycles) exec_stat.max_cycles = (uint32_t)cycles;
+}
+
+/*
+ * exec_stats_dump
+ *   DESCRIPTION: send the execute statistics over COM1, one
+ *                "count clean max avg zero_avg" line in TSC cycles after a
+ *                header giving the rate. zero_avg is the clearing on
+ *                demand averaged over the executes that needed it
+ *   INPUTS: none
+ *   OUTPUTS: the statistics on the serial port
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: busy-waits on the UART
+ */
+void exec_stats_dump()
+{
+  int8_t buf[PREZERO_LINE_SIZE];
+  uint32_t dirty = exec_stat.count - exec_stat.clean;
+  uint64_t avg = 0, zero_avg = 0;
+
+  if (exec_stat.count != 0) avg = div64_32(exec_stat.total_cycles, exec_stat.count, NULL);
+  if (dirty != 0) zero_avg = div64_32(exec_stat.zero_cycles, dirty, NULL);
+
+  serial_puts_polled("# exec tsc_khz=");
+  serial_puts_polled(itoa(clock_tsc_khz(), buf, 10));
+  serial_puts_polled("\n");
+
+  serial_puts_polled(itoa(exec_stat.count, buf, 10));
+  serial_puts_polled(" ");
+  serial_puts_polled(itoa(exec_stat.clean, buf, 10));
+  serial_puts_polled(" ");
+  serial_puts_polled(itoa(exec_stat.max_cycles, buf, 10));
+  serial_puts_polled(" ");
+  serial_puts_polled(itoa((uint32_t)avg, buf, 10));
+  serial_puts_polled(" ");
+  serial_puts_polled(itoa((uint32_t)zero_avg, buf, 10));
+  serial_puts_polled("\n# end\n");
+}
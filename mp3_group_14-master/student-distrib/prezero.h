@@ -0,0 +1,35 @@
+#ifndef PREZERO_H
+#define PREZERO_H
+
+#include "types.h"
+
+// the zeroer clears this much at a time, with preemption off
+#define PREZERO_CHUNK       0x10000
+#define PREZERO_LINE_SIZE   24
+
+// the state of the program frame of a pid
+#define FRAME_DIRTY         0   /* holds what its last process left */
+#define FRAME_ZEROING       1   /* the zeroer is on it */
+#define FRAME_CLEAN         2   /* all zero, ready for execute */
+#define FRAME_IN_USE        3   /* a process runs in it */
+
+/* how long execute took, in TSC cycles, from the call to the iret */
+typedef struct exec_stat {
+  uint32_t count;           /* programs started */
+  uint32_t clean;           /* of those, how many got a cleared frame */
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint64_t zero_cycles;     /* spent clearing frames on demand */
+} exec_stat_t;
+
+void prezero_init();
+
+void prezero_claim(uint32_t pid);
+
+void prezero_release(uint32_t pid);
+
+void exec_latency_record(uint64_t cycles);
+
+void exec_stats_dump();
+
+#endif
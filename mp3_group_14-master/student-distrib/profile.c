@@ -0,0 +1,295 @@
+#include "profile.h"
+#include "lib.h"
+#include "pcb.h"
+#include "serial.h"
+
+// the histogram, an open addressed hash on (program, eip)
+static profile_bucket_t profile_table[PROFILE_BUCKETS];
+static int8_t profile_programs[PROFILE_PROGRAMS][PROCESS_NAME_LEN + 1];
+static uint32_t profile_program_samples[PROFILE_PROGRAMS];
+static uint32_t profile_samples = 0;
+static uint32_t profile_dropped = 0;
+static volatile uint32_t profile_enabled = 0;
+
+// the kernel symbols, copied out of the multiboot info before paging
+static elf_sym_t profile_symtab[PROFILE_SYMTAB_SIZE / sizeof(elf_sym_t)];
+static int8_t profile_strtab[PROFILE_STRTAB_SIZE];
+static uint32_t profile_nsyms = 0;
+
+// per dump counts, indexed by symbol or by bucket
+static uint32_t profile_scratch[PROFILE_BUCKETS];
+
+/*
+ * profile_init
+ *   DESCRIPTION: keep a copy of the kernel symbol table that GRUB loaded
+ *                along with bootimg, so a dump can print function names.
+ *                Must run before paging, the tables may be anywhere
+ *   INPUTS: multiboot_info_t *mbi -- the multiboot info from GRUB
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: dumps print raw addresses if there is no usable table
+ */
+void profile_init(multiboot_info_t *mbi)
+{
+  elf_shdr_t *shdrs = (elf_shdr_t *)mbi->elf_sec.addr;
+  elf_shdr_t *symtab, *strtab;
+  uint32_t i;
+
+  for (i = 0; i < mbi->elf_sec.num; i++)
+  {
+    if (shdrs[i].sh_type != SHT_SYMTAB || shdrs[i].sh_link >= mbi->elf_sec.num)
+      continue;
+    symtab = &shdrs[i];
+    strtab = &shdrs[symtab->sh_link];
+    if (symtab->sh_addr == 0 || strtab->sh_addr == 0)
+      return;
+    // a table too big for the copy is cut short, the names must fit whole
+    if (strtab->sh_size > PROFILE_STRTAB_SIZE)
+      return;
+    profile_nsyms = symtab->sh_size / sizeof(elf_sym_t);
+    if (profile_nsyms > PROFILE_SYMTAB_SIZE / sizeof(elf_sym_t))
+      profile_nsyms = PROFILE_SYMTAB_SIZE / sizeof(elf_sym_t);
+    memcpy(profile_symtab, (void *)symtab->sh_addr, profile_nsyms * sizeof(elf_sym_t));
+    memcpy(profile_strtab, (void *)strtab->sh_addr, strtab->sh_size);
+    profile_strtab[PROFILE_STRTAB_SIZE - 1] = '\0';
+    return;
+  }
+}
+
+/*
+ * profile_program
+ *   DESCRIPTION: find the slot of a program name, taking a free one the
+ *                first time the program is seen
+ *   INPUTS: const int8_t *name -- the name the process was executed as
+ *   OUTPUTS: none
+ *   RETURN VALUE: the slot, PROFILE_PROGRAMS when all slots are taken
+ *   SIDE EFFECTS: none
+ */
+static uint32_t profile_program(const int8_t *name)
+{
+  uint32_t i;
+
+  for (i = PROFILE_KERNEL + 1; i < PROFILE_PROGRAMS; i++)
+  {
+    if (profile_programs[i][0] == '\0')
+    {
+      strncpy(profile_programs[i], name, PROCESS_NAME_LEN);
+      return i;
+    }
+    if (strncmp(profile_programs[i], name, PROCESS_NAME_LEN) == 0)
+      return i;
+  }
+  return PROFILE_PROGRAMS;
+}
+
+/*
+ * profile_sample
+ *   DESCRIPTION: called by the PIT linker on every tick, count the
+ *                interrupted eip against the kernel or against the
+ *                program of the current process
+ *   INPUTS: hw_context_t *regs -- the frame of the interrupt
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: a sample that finds the histogram full is dropped
+ */
+void profile_sample(hw_context_t *regs)
+{
+  uint32_t program, slot, i;
+  profile_bucket_t *bucket;
+
+  if (!profile_enabled) return;
+
+  if ((regs->cs & PRIVILEGE_MASK) == 0)
+    program = PROFILE_KERNEL;
+  else
+    program = profile_program(get_pcb()->name);
+  if (program == PROFILE_PROGRAMS)
+  {
+    profile_dropped++;
+    return;
+  }
+
+  slot = (regs->return_address ^ program * PROFILE_HASH) * PROFILE_HASH;
+  for (i = 0; i < PROFILE_BUCKETS; i++)
+  {
+    bucket = &profile_table[(slot + i) & (PROFILE_BUCKETS - 1)];
+    if (bucket->count == 0)
+    {
+      bucket->eip = regs->return_address;
+      bucket->program = program;
+    }
+    else if (bucket->eip != regs->return_address || bucket->program != program)
+    {
+      continue;
+    }
+    bucket->count++;
+    profile_program_samples[program]++;
+    profile_samples++;
+    return;
+  }
+  profile_dropped++;
+}
+
+/*
+ * profile_command
+ *   DESCRIPTION: the work of the profile system call
+ *   INPUTS: int32_t cmd -- PROFILE_START, PROFILE_STOP or PROFILE_DUMP
+ *   OUTPUTS: the profile on COM1 for PROFILE_DUMP
+ *   RETURN VALUE: the number of samples, -1 for a bad command
+ *   SIDE EFFECTS: PROFILE_START throws away the previous histogram
+ */
+int32_t profile_command(int32_t cmd)
+{
+  uint32_t flags;
+
+  switch (cmd)
+  {
+    case PROFILE_START:
+      cli_and_save(flags);
+      memset(profile_table, 0, sizeof(profile_table));
+      memset(profile_programs, 0, sizeof(profile_programs));
+      memset(profile_program_samples, 0, sizeof(profile_program_samples));
+      strncpy(profile_programs[PROFILE_KERNEL], "kernel", PROCESS_NAME_LEN);
+      profile_samples = 0;
+      profile_dropped = 0;
+      profile_enabled = 1;
+      restore_flags(flags);
+      break;
+    case PROFILE_STOP:
+      profile_enabled = 0;
+      break;
+    case PROFILE_DUMP:
+      profile_dump();
+      break;
+    default:
+      return -1;
+  }
+  return profile_samples;
+}
+
+/*
+ * profile_symbol
+ *   DESCRIPTION: find the kernel function an address falls in
+ *   INPUTS: uint32_t eip -- the address
+ *   OUTPUTS: none
+ *   RETURN VALUE: the symbol index, profile_nsyms if there is none
+ *   SIDE EFFECTS: none
+ */
+static uint32_t profile_symbol(uint32_t eip)
+{
+  uint32_t i;
+  elf_sym_t *sym;
+
+  for (i = 0; i < profile_nsyms; i++)
+  {
+    sym = &profile_symtab[i];
+    if (ELF_ST_TYPE(sym->st_info) != STT_FUNC) continue;
+    if (eip >= sym->st_value && eip - sym->st_value < sym->st_size)
+      return i;
+  }
+  return profile_nsyms;
+}
+
+/*
+ * profile_print_top
+ *   DESCRIPTION: print the largest counts as "count percent label" lines,
+ *                largest first
+ *   INPUTS: uint32_t n -- how many entries of profile_scratch are used
+ *           uint32_t total -- what the percentages are of
+ *           uint32_t by_symbol -- YES if the entries are kernel symbols,
+ *                                 NO if they are histogram buckets
+ *   OUTPUTS: the lines on COM1
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the printed entries of profile_scratch are cleared
+ */
+static void profile_print_top(uint32_t n, uint32_t total, uint32_t by_symbol)
+{
+  uint32_t i, line, best;
+  int8_t buf[PROFILE_LINE_SIZE];
+
+  for (line = 0; line < PROFILE_TOP; line++)
+  {
+    best = n;
+    for (i = 0; i < n; i++)
+      if (profile_scratch[i] != 0 && (best == n || profile_scratch[i] > profile_scratch[best]))
+        best = i;
+    if (best == n) return;
+
+    serial_puts_polled(itoa(profile_scratch[best], buf, 10));
+    serial_puts_polled(" ");
+    serial_puts_polled(itoa(profile_scratch[best] * 100 / total, buf, 10));
+    serial_puts_polled("% ");
+    if (!by_symbol)
+    {
+      serial_puts_polled("0x");
+      serial_puts_polled(itoa(profile_table[best].eip, buf, 16));
+    }
+    else if (best == profile_nsyms || profile_symtab[best].st_name >= PROFILE_STRTAB_SIZE)
+    {
+      serial_puts_polled("?");
+    }
+    else
+    {
+      serial_puts_polled(&profile_strtab[profile_symtab[best].st_name]);
+    }
+    serial_puts_polled("\n");
+    profile_scratch[best] = 0;
+  }
+}
+
+/*
+ * profile_dump
+ *   DESCRIPTION: send a flat profile over COM1, the kernel part by
+ *                function from the bootimg symbols, each program by eip.
+ *                The programs on the file system are stripped, nm on the
+ *                .exe from syscalls/ names their addresses
+ *   INPUTS: none
+ *   OUTPUTS: the profile on the serial port
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: busy-waits on the UART, no samples are taken while
+ *                 it runs
+ */
+void profile_dump()
+{
+  uint32_t i, program, was_enabled;
+  int8_t buf[PROFILE_LINE_SIZE];
+
+  was_enabled = profile_enabled;
+  profile_enabled = 0;
+
+  serial_puts_polled("# profile samples=");
+  serial_puts_polled(itoa(profile_samples, buf, 10));
+  serial_puts_polled(" dropped=");
+  serial_puts_polled(itoa(profile_dropped, buf, 10));
+  serial_puts_polled("\n");
+
+  for (program = 0; program < PROFILE_PROGRAMS; program++)
+  {
+    if (profile_program_samples[program] == 0) continue;
+    serial_puts_polled("# ");
+    serial_puts_polled(profile_programs[program]);
+    serial_puts_polled(" samples=");
+    serial_puts_polled(itoa(profile_program_samples[program], buf, 10));
+    serial_puts_polled("\n");
+
+    memset(profile_scratch, 0, sizeof(profile_scratch));
+    if (program == PROFILE_KERNEL)
+    {
+      // fold the kernel buckets into their functions
+      for (i = 0; i < PROFILE_BUCKETS; i++)
+        if (profile_table[i].count != 0 && profile_table[i].program == program)
+          profile_scratch[profile_symbol(profile_table[i].eip)] += profile_table[i].count;
+      profile_print_top(profile_nsyms + 1, profile_program_samples[program], YES);
+    }
+    else
+    {
+      for (i = 0; i < PROFILE_BUCKETS; i++)
+        if (profile_table[i].program == program)
+          profile_scratch[i] = profile_table[i].count;
+      profile_print_top(PROFILE_BUCKETS, profile_program_samples[program], NO);
+    }
+  }
+  serial_puts_polled("# end\n");
+
+  profile_enabled = was_enabled;
+}
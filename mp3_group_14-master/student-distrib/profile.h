@@ -0,0 +1,73 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "types.h"
+#include "multiboot.h"
+#include "signal.h"
+
+// commands of the profile system call
+#define PROFILE_START       0   /* clear the histogram and start sampling */
+#define PROFILE_STOP        1   /* stop sampling, keep the histogram */
+#define PROFILE_DUMP        2   /* send the flat profile over COM1 */
+
+// distinct (program, eip) pairs kept, a power of two for the hash
+#define PROFILE_BUCKETS     2048
+// distinct programs told apart, slot 0 holds the kernel
+#define PROFILE_PROGRAMS    16
+#define PROFILE_KERNEL      0
+// lines printed per program in a dump
+#define PROFILE_TOP         20
+
+// room for the kernel symbols copied from the multiboot info
+#define PROFILE_SYMTAB_SIZE 0x4000
+#define PROFILE_STRTAB_SIZE 0x2000
+
+// the parts of ELF the symbol lookup needs
+#define SHT_SYMTAB          2
+#define STT_FUNC            2
+#define ELF_ST_TYPE(info)   ((info) & 0xF)
+
+#define PRIVILEGE_MASK      0x3
+#define PROFILE_HASH        0x9E3779B1
+#define PROFILE_LINE_SIZE   16
+
+/* an ELF section header */
+typedef struct elf_shdr {
+  uint32_t sh_name;
+  uint32_t sh_type;
+  uint32_t sh_flags;
+  uint32_t sh_addr;
+  uint32_t sh_offset;
+  uint32_t sh_size;
+  uint32_t sh_link;
+  uint32_t sh_info;
+  uint32_t sh_addralign;
+  uint32_t sh_entsize;
+} elf_shdr_t;
+
+/* an ELF symbol table entry */
+typedef struct elf_sym {
+  uint32_t st_name;
+  uint32_t st_value;
+  uint32_t st_size;
+  uint8_t st_info;
+  uint8_t st_other;
+  uint16_t st_shndx;
+} elf_sym_t;
+
+/* how often one eip of one program was interrupted */
+typedef struct profile_bucket {
+  uint32_t eip;
+  uint32_t program;
+  uint32_t count;
+} profile_bucket_t;
+
+void profile_init(multiboot_info_t *mbi);
+
+void profile_sample(hw_context_t *regs);
+
+int32_t profile_command(int32_t cmd);
+
+void profile_dump();
+
+#endif
@@ -0,0 +1,117 @@
+#include "ring.h"
+#include "paging.h"
+#include "do_sys.h"
+#include "signal.h"
+
+static ring_state_t rings[MAX_PROCESS_NUM];
+
+/*
+ * ring_do
+ *   DESCRIPTION: run one submission through the same read and write the
+ *                system calls use
+ *   INPUTS: ring_sqe_t *sqe -- a copy of the submission
+ *   OUTPUTS: none
+ *   RETURN VALUE: what the operation returned, -1 for a bad submission
+ *   SIDE EFFECTS: a read may sleep like the read system call
+ */
+static int32_t ring_do(ring_sqe_t *sqe)
+{
+  switch (sqe->opcode)
+  {
+  case RING_OP_NOP:
+    return 0;
+  case RING_OP_READ:
+  case RING_OP_WRITE:
+    if (sqe->len <= 0) return -1;
+    if (!user_range_valid(sqe->buf, sqe->len)) return -1;
+    if (sqe->opcode == RING_OP_READ) return read(sqe->fd, sqe->buf, sqe->len);
+    return write(sqe->fd, sqe->buf, sqe->len);
+  default:
+    return -1;
+  }
+}
+
+/*
+ * ring_create
+ *   DESCRIPTION: map a submission and a completion ring into a process,
+ *                both empty
+ *   INPUTS: uint32_t pid -- the process
+ *   OUTPUTS: none
+ *   RETURN VALUE: the user address of the rings, -1 if no frame is left
+ *   SIDE EFFECTS: a second call returns the rings already mapped
+ */
+int32_t ring_create(uint32_t pid)
+{
+  uint32_t frame;
+
+  if (pid >= MAX_PROCESS_NUM) return -1;
+  if (rings[pid].ring != NULL) return USER_RING_ADDR;
+
+  // the frame comes cleared, so all four indices start at 0
+  if ((frame = map_user_ring_page(pid)) == 0) return -1;
+  rings[pid].ring = (io_ring_t *)frame;
+  rings[pid].sq_head = 0;
+  rings[pid].cq_tail = 0;
+  return USER_RING_ADDR;
+}
+
+/*
+ * ring_drain
+ *   DESCRIPTION: run the submissions a process queued, in order, and post
+ *                a completion for each. The kernel keeps its own heads, so
+ *                whatever the process writes into the page only decides
+ *                how much is done, never where the kernel writes
+ *   INPUTS: uint32_t pid -- the current process
+ *           uint32_t to_submit -- the most submissions to run
+ *   OUTPUTS: the completions in the completion ring
+ *   RETURN VALUE: the number of submissions run, -1 without a ring
+ *   SIDE EFFECTS: stops early when the completion ring is full or a
+ *                 signal kills the process
+ */
+int32_t ring_drain(uint32_t pid, uint32_t to_submit)
+{
+  uint32_t done = 0;
+  ring_sqe_t sqe;
+  ring_cqe_t *cqe;
+  ring_state_t *state;
+  io_ring_t *ring;
+
+  if (pid >= MAX_PROCESS_NUM || rings[pid].ring == NULL) return -1;
+  state = &rings[pid];
+  ring = state->ring;
+
+  while (done < to_submit && state->sq_head != ring->sq_tail)
+  {
+    // no room for the completion, the process has to reap first
+    if (state->cq_tail - ring->cq_head >= RING_ENTRIES) break;
+    if (signal_kill_pending()) break;
+
+    // a copy, the process may change the slot while it runs
+    sqe = ring->sq[state->sq_head & RING_MASK];
+    state->sq_head++;
+    ring->sq_head = state->sq_head;
+
+    cqe = &ring->cq[state->cq_tail & RING_MASK];
+    cqe->user_data = sqe.user_data;
+    cqe->result = ring_do(&sqe);
+    state->cq_tail++;
+    ring->cq_tail = state->cq_tail;
+    done++;
+  }
+  return done;
+}
+
+/*
+ * ring_release
+ *   DESCRIPTION: unmap the rings of a process and free their frame
+ *   INPUTS: uint32_t pid -- the process that is halting
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void ring_release(uint32_t pid)
+{
+  if (pid >= MAX_PROCESS_NUM || rings[pid].ring == NULL) return;
+  delete_user_ring_page(pid);
+  rings[pid].ring = NULL;
+}
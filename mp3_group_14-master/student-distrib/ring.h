@@ -0,0 +1,55 @@
+#ifndef RING_H
+#define RING_H
+
+#include "types.h"
+
+// slots of each ring, a power of two so the free running indices wrap
+#define RING_ENTRIES        128
+#define RING_MASK           (RING_ENTRIES - 1)
+
+// operations of a submission
+#define RING_OP_NOP         0
+#define RING_OP_READ        1
+#define RING_OP_WRITE       2
+
+/* one submission, filled in by the process */
+typedef struct ring_sqe {
+  uint32_t opcode;
+  int32_t fd;
+  void *buf;
+  int32_t len;
+  uint32_t user_data;     /* handed back in the completion */
+} ring_sqe_t;
+
+/* one completion, filled in by the kernel */
+typedef struct ring_cqe {
+  uint32_t user_data;
+  int32_t result;         /* what the read or write returned */
+} ring_cqe_t;
+
+/* the page shared with the process. The process moves sq_tail and
+ * cq_head, the kernel sq_head and cq_tail. Indices run free and are
+ * masked with RING_MASK */
+typedef struct io_ring {
+  volatile uint32_t sq_head;
+  volatile uint32_t sq_tail;
+  volatile uint32_t cq_head;
+  volatile uint32_t cq_tail;
+  ring_sqe_t sq[RING_ENTRIES];
+  ring_cqe_t cq[RING_ENTRIES];
+} io_ring_t;
+
+/* what the kernel keeps of a ring, the process can scribble on the page */
+typedef struct ring_state {
+  io_ring_t *ring;        /* the frame, through the kernel mapping */
+  uint32_t sq_head;
+  uint32_t cq_tail;
+} ring_state_t;
+
+int32_t ring_create(uint32_t pid);
+
+int32_t ring_drain(uint32_t pid, uint32_t to_submit);
+
+void ring_release(uint32_t pid);
+
+#endif
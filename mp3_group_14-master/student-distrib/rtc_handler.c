@@ -1,6 +1,11 @@
 #include "rtc_handler.h"
+#include "schedule.h"
 
-volatile int intr_rtc = 0;              // flag: 1 if an rtc interrupt occured
+volatile uint32_t rtc_ticks = 0;        // rtc interrupts since boot
+volatile int rtc_waiters = 0;           // number of processes sleeping in rtc_read
+
+// the index and data ports are a pair, nothing may come in between
+static spinlock_t rtc_lock = SPINLOCK_INIT("rtc");
 
 /*
  * rtc_init
@@ -13,8 +18,9 @@ volatile int intr_rtc = 0;              // flag: 1 if an rtc interrupt occured
 extern void rtc_init(){
   char reg_b;                 // RTC register B
   char reg_a;
+  uint32_t flags;
   // set rtc registers
-  cli();
+  flags = spin_lock_irqsave(&rtc_lock);
   outb(RTC_REGISTER_B|RTC_NMI,RTC_COMMAND_PORT);
   reg_b = inb(RTC_DATA_PORT);
 
@@ -28,10 +34,12 @@ extern void rtc_init(){
   reg_a = inb(RTC_DATA_PORT);
   outb(RTC_REGISTER_A|RTC_NMI,RTC_COMMAND_PORT);
   outb((reg_a & WRITE_REG_A_MASK)|DEFAULT_RATE,RTC_DATA_PORT);
+  // the RTC is the reference the interrupt latency is measured against
+  irq_latency_period(IRQ_NUM_EIGHT, 1 << (DEFAULT_RATE - RATE_OFFSET), RTC_BASE_HZ);
 
   // enable irq_8
   enable_irq(IRQ_NUM_EIGHT);
-  sti();
+  spin_unlock_irqrestore(&rtc_lock, flags);
 }
 
 /*
@@ -44,6 +52,7 @@ extern void rtc_init(){
 int32_t
 rtc_write(int32_t fd, const void* buf, int32_t nbytes){
   char reg_a;
+  uint32_t flags;
   int8_t new_rate = 0;
   int32_t rate = *((int32_t *)buf);
  // sanity check
@@ -56,12 +65,13 @@ rtc_write(int32_t fd, const void* buf, int32_t nbytes){
   while(rate >>= 1) new_rate += 1;  // now  new_rate  log(2)(rate)
   new_rate = FIFTEEN - new_rate + RATE_OFFSET;  // compute dividend
  // change rtc rate
-  cli();
+  flags = spin_lock_irqsave(&rtc_lock);
     outb(RTC_REGISTER_A|RTC_NMI,RTC_COMMAND_PORT);
     reg_a = inb(RTC_DATA_PORT);
     outb(RTC_REGISTER_A|RTC_NMI,RTC_COMMAND_PORT);
     outb((reg_a & WRITE_REG_A_MASK)|new_rate,RTC_DATA_PORT);
-  sti();
+    irq_latency_period(IRQ_NUM_EIGHT, 1 << (new_rate - RATE_OFFSET), RTC_BASE_HZ);
+  spin_unlock_irqrestore(&rtc_lock, flags);
   return 0;
 }
 
@@ -74,28 +84,56 @@ rtc_write(int32_t fd, const void* buf, int32_t nbytes){
  * output: none
  */
 extern void rtc_handler(int32_t fd, const void* buf, int32_t nbytes){
+  uint32_t flags = spin_lock_irqsave(&rtc_lock);
   outb(RTC_REGISTER_C,RTC_COMMAND_PORT); // select register C
   inb(RTC_DATA_PORT);                    // throw away whatever we just read
+  spin_unlock_irqrestore(&rtc_lock, flags);
   // test_interrupts();                  // test whether it works
-  intr_rtc = 1;                          // flag an interrupt has occured
+  rtc_ticks++;                           // count the interrupt
+  if (rtc_waiters || poll_waiters)       // let the readers run
+    wake_all_terminals();
   send_eoi(IRQ_NUM_EIGHT);               // send EOI after handler finishs
 }
 
 /*
  * rtc_read
  * description:
- * wait until an rtc interrupt occur and return 0
- * input: none
- * output: 0 when rtc interrupt occur
+ * wait until an rtc interrupt occur and return 0. One that came since the
+ * descriptor was opened or last read counts, as poll reported it
+ * input: fd -- the rtc descriptor, its file position is the tick it last saw
+ * output: 0 when rtc interrupt occur, -EAGAIN when none came and the
+ *         descriptor is O_NONBLOCK
  */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
-  intr_rtc = 0;                           // wait for rtc interrupt
-  // sti();
-  while(!intr_rtc);
-  // cli();
+  uint32_t flags;
+  fd_t *file = &get_pcb()->descriptors[fd];
+  cli_and_save(flags);
+  if ((file->f_status & O_NONBLOCK) && file->f_file_position == rtc_ticks){
+    restore_flags(flags);
+    return -EAGAIN;                       // no tick yet and the caller will not wait
+  }
+  rtc_waiters++;
+  while(file->f_file_position == rtc_ticks) idle_wait();  // sleep in hlt until it comes
+  rtc_waiters--;
+  file->f_file_position = rtc_ticks;
+  restore_flags(flags);
   return 0;
 }
 
+/*
+ * rtc_poll
+ * description:
+ * the poll entry of the rtc, readable once an interrupt came that the
+ * descriptor has not read yet
+ * input: fd -- the rtc descriptor
+ * output: POLLIN when a read would not wait, writes never do
+ */
+int32_t rtc_poll(int32_t fd){
+  if (get_pcb()->descriptors[fd].f_file_position != rtc_ticks)
+    return POLLIN | POLLOUT;
+  return POLLOUT;
+}
+
 /*
  * rtc_close
  * description:
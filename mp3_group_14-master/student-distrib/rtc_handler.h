@@ -5,6 +5,10 @@
 #include "i8259.h"
 #include "x86_desc.h"
 #include "types.h"
+#include "spinlock.h"
+#include "latency.h"
+#include "poll.h"
+#include "pcb.h"
 
 #define RTC_COMMAND_PORT 0x70
 #define RTC_DATA_PORT    0x71
@@ -27,6 +31,7 @@
 #define FIFTEEN           15 //2^15
 #define RATE_OFFSET       1
 #define RTC_BYTE_MAX      4
+#define RTC_BASE_HZ       32768 // the interrupt comes every 2^(rate-1) of these
 
 
 extern void rtc_init();
@@ -35,6 +40,10 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 int32_t rtc_close(int32_t fd);
 int32_t rtc_open(const uint8_t * filename);
+int32_t rtc_poll(int32_t fd);
+
+// counts rtc interrupts, a descriptor keeps the count it last read
+extern volatile uint32_t rtc_ticks;
 
 
 
@@ -1,4 +1,8 @@
 #include "schedule.h"
+#include "pit.h"
+#include "thread.h"
+
+volatile int32_t poll_waiters = 0;
 
 /*
  * initialize_new_ternimal
@@ -22,7 +26,7 @@ void initialize_new_ternimals()
         terminals[i].saved_ebp = my_ebp;
         terminals[i].saved_esp = my_esp;
         terminals[i].enter_flag = LOW;
-        terminals[i].user_vid_mem = LOW;
+        terminals[i].waiting = NO;
     }
     terminals[TERM_ZERO].initialized = YES;
 
@@ -72,11 +76,40 @@ void switch_screen(uint32_t next_terminal_id) {
     set_y(terminals[next_terminal_id].y_pos);
     update_cursor(terminals[next_terminal_id].x_pos, terminals[next_terminal_id].y_pos);
 
+    // processes that called vidmap follow their terminal on or off the screen
+    remap_user_video(current_looking_terminal, next_terminal_id);
+
     // update the current looking id
     current_looking_terminal = next_terminal_id;
+    vdso_set_looking(next_terminal_id);
 
 }
 
+/*
+ * remap_user_video
+ * description: point the vidmap page of every process on the two terminals
+ *              at the right place after a screen switch
+ * input: old_terminal_id -- the terminal that goes off the screen
+ *        new_terminal_id -- the terminal that is shown now
+ * output: none
+ */
+void remap_user_video(uint32_t old_terminal_id, uint32_t new_terminal_id)
+{
+    int pid;
+    pcb_t *pcb;
+
+    for (pid = 0; pid < MAX_PROCESS_NUM; pid++)
+    {
+        if (process[pid] == PROCESS_OFF) continue;
+        pcb = get_pcb_by_pid(pid);
+        if (pcb->vid_mapped == LOW) continue;
+        if (pcb->terminal_id == new_terminal_id)
+            reset_video_page(pid, VID_MEM_ADDR);
+        else if (pcb->terminal_id == old_terminal_id)
+            reset_video_page(pid, VID_MEM_BUFFER1 + old_terminal_id * _4KB);
+    }
+}
+
 /*
  * get_current_running_terminal
  * description: get the current running terminal id
@@ -118,3 +151,86 @@ int32_t get_current_looking_terminal() {
     return current_looking_terminal;
 }
 
+
+/*
+ * idle_wait
+ * description: block the running terminal until the next interrupt. The
+ *              terminal is marked waiting so the scheduler skips it, and the
+ *              cpu sleeps in hlt instead of spinning. Called with interrupts
+ *              off and returns with them off, so the caller can check its
+ *              wait condition without losing a wakeup
+ * input: none
+ * output: none
+ */
+void idle_wait()
+{
+    terminals[current_running_terminal].waiting = YES;
+    // sti takes effect after the next instruction, so hlt cannot miss an interrupt
+    asm volatile("sti; hlt; cli" : : : "memory", "cc");
+    terminals[current_running_terminal].waiting = NO;
+}
+
+/*
+ * wake_terminal
+ * description: make the process of a terminal runnable again after the
+ *              event it waits for, and bring the PIT back to periodic
+ *              mode so the scheduler gets to it soon
+ * input: t_id -- the terminal to wake
+ * output: none
+ */
+void wake_terminal(uint32_t t_id)
+{
+    if (t_id >= MAX_TERMINAL_NUM) return;
+    // the event may be for a thread another thread of its program displaced
+    if (thread_wake_terminal(t_id) == 0 && terminals[t_id].waiting == NO) return;
+    terminals[t_id].waiting = NO;
+    pit_kick();
+}
+
+/*
+ * wake_all_terminals
+ * description: wake every terminal, for events any process may wait on
+ * input: none
+ * output: none
+ */
+void wake_all_terminals()
+{
+    int i;
+    for (i = 0; i < MAX_TERMINAL_NUM; i++)
+        wake_terminal(i);
+}
+
+/*
+ * next_runnable_terminal
+ * description: round robin over the terminals, skipping those waiting
+ *              with no other thread of their program to run
+ * input: t_id -- the terminal running now
+ * output: the next terminal that is not waiting, or t_id if all of them are
+ */
+int32_t next_runnable_terminal(uint32_t t_id)
+{
+    int i, next;
+    for (i = 1; i < MAX_TERMINAL_NUM; i++)
+    {
+        next = (t_id + i) % MAX_TERMINAL_NUM;
+        if (terminals[next].waiting == NO || thread_runnable(next)) return next;
+    }
+    return t_id;
+}
+
+/*
+ * all_terminals_waiting
+ * description: check whether nothing is runnable, then the PIT can sleep
+ *              until the next deadline
+ * input: none
+ * output: YES if every terminal is waiting, NO otherwise
+ */
+int32_t all_terminals_waiting()
+{
+    int i;
+    for (i = 0; i < MAX_TERMINAL_NUM; i++)
+    {
+        if (terminals[i].waiting == NO || thread_runnable(i)) return NO;
+    }
+    return YES;
+}
@@ -7,6 +7,7 @@
 #include "paging.h"
 #include "do_sys.h"
 #include "x86_desc.h"
+#include "vdso.h"
 
 #define MAX_TERMINAL_NUM            3
 #define _2MB                        0x00200000
@@ -37,8 +38,10 @@ typedef struct{
 
     //this stores the current pid number running on one terminal
     int32_t current_pid;
-    int32_t user_vid_mem;
     int curr_buffer_ptr;
+
+    // YES while the process of the terminal sleeps in idle_wait
+    volatile int32_t waiting;
 } scheduler_t;
 
 scheduler_t terminals[MAX_TERMINAL_NUM];
@@ -51,9 +54,20 @@ void initialize_new_ternimals();
 
 void switch_screen(uint32_t next_terminal_id);
 
+void remap_user_video(uint32_t old_terminal_id, uint32_t new_terminal_id);
+
 int32_t get_current_running_terminal();
 int32_t get_current_looking_terminal();
 
 void set_next_running_terminal(uint32_t cur_running);
 
+// processes sleeping in poll, woken by any event source
+extern volatile int32_t poll_waiters;
+
+void idle_wait();
+void wake_terminal(uint32_t t_id);
+void wake_all_terminals();
+int32_t next_runnable_terminal(uint32_t t_id);
+int32_t all_terminals_waiting();
+
 #endif
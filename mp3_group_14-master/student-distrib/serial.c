@@ -0,0 +1,319 @@
+#include "serial.h"
+#include "schedule.h"
+
+// transmit and receive rings, head is where the next byte goes in
+static uint8_t tx_ring[SERIAL_TX_SIZE];
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static uint8_t rx_ring[SERIAL_RX_SIZE];
+static volatile uint32_t rx_head = 0;
+static volatile uint32_t rx_tail = 0;
+
+// processes sleeping until there is room to send or data to read
+static volatile int32_t tx_waiters = 0;
+static volatile int32_t rx_waiters = 0;
+
+/*
+ * serial_init
+ * description:
+ * set COM1 up for 115200 8N1 with the FIFOs on, take IRQ4 for receive,
+ * and mirror the console to it
+ * input: none
+ * output: none
+ */
+void serial_init()
+{
+    // no interrupts from the UART while it is set up
+    outb(0x00, COM1_PORT + UART_IER);
+
+    // divisor latch, low byte then high byte
+    outb(UART_LCR_DLAB, COM1_PORT + UART_LCR);
+    outb(UART_DIVISOR & 0xFF, COM1_PORT + UART_DLL);
+    outb(UART_DIVISOR >> 8, COM1_PORT + UART_DLM);
+    outb(UART_LCR_8N1, COM1_PORT + UART_LCR);
+
+    outb(UART_FCR_ENABLE, COM1_PORT + UART_FCR);
+    outb(UART_MCR_ON, COM1_PORT + UART_MCR);
+
+    // transmit interrupts are only on while the ring has data
+    outb(UART_IER_RX, COM1_PORT + UART_IER);
+    enable_irq(SERIAL_IRQ);
+
+    // the kernel log goes to the serial port as well as the screen
+    set_console_sink(serial_klog_putc);
+}
+
+/*
+ * serial_putc_polled
+ * description:
+ * send one byte, waiting until the transmitter has room. Safe from any
+ * context, including with interrupts off
+ * input: c -- the byte to send
+ * output: none
+ */
+void serial_putc_polled(uint8_t c)
+{
+    while (!(inb(COM1_PORT + UART_LSR) & UART_LSR_THRE));
+    outb(c, COM1_PORT + UART_DATA);
+}
+
+/*
+ * serial_puts_polled
+ * description:
+ * send a string, with \n sent as \r\n
+ * input: s -- the string to send
+ * output: none
+ */
+void serial_puts_polled(const int8_t *s)
+{
+    while (*s != '\0')
+    {
+        if (*s == '\n')
+            serial_putc_polled('\r');
+        serial_putc_polled(*s++);
+    }
+}
+
+/*
+ * serial_tx_fill
+ * description:
+ * move bytes from the transmit ring into the UART FIFO when it is empty,
+ * and keep the transmit interrupt on only while bytes are left.
+ * Called with interrupts off
+ * input: none
+ * output: none
+ */
+static void serial_tx_fill()
+{
+    int32_t i;
+
+    if (inb(COM1_PORT + UART_LSR) & UART_LSR_THRE)
+    {
+        // the FIFO is empty, it takes UART_FIFO_SIZE bytes at once
+        for (i = 0; i < UART_FIFO_SIZE && tx_tail != tx_head; i++)
+        {
+            outb(tx_ring[tx_tail], COM1_PORT + UART_DATA);
+            tx_tail = (tx_tail + 1) % SERIAL_TX_SIZE;
+        }
+    }
+    if (tx_tail != tx_head)
+        outb(UART_IER_RX | UART_IER_TX, COM1_PORT + UART_IER);
+    else
+        outb(UART_IER_RX, COM1_PORT + UART_IER);
+}
+
+/*
+ * serial_tx_push
+ * description:
+ * append a byte to the transmit ring. Called with interrupts off
+ * input: c -- the byte to send
+ * output: 0 for success, -1 if the ring is full
+ */
+static int32_t serial_tx_push(uint8_t c)
+{
+    uint32_t next = (tx_head + 1) % SERIAL_TX_SIZE;
+
+    if (next == tx_tail)
+        return -1;
+    tx_ring[tx_head] = c;
+    tx_head = next;
+    return 0;
+}
+
+/*
+ * serial_handler
+ * description:
+ * IRQ4, drain the receive FIFO into the receive ring and refill the
+ * transmit FIFO from the transmit ring, then wake whoever waits on them
+ * input: none
+ * output: none
+ */
+void serial_handler()
+{
+    uint32_t next;
+
+    while (!(inb(COM1_PORT + UART_IIR) & UART_IIR_NONE))
+    {
+        while (inb(COM1_PORT + UART_LSR) & UART_LSR_DR)
+        {
+            next = (rx_head + 1) % SERIAL_RX_SIZE;
+            // when the ring is full the byte is dropped
+            if (next != rx_tail)
+            {
+                rx_ring[rx_head] = inb(COM1_PORT + UART_DATA);
+                rx_head = next;
+            }
+            else
+            {
+                inb(COM1_PORT + UART_DATA);
+            }
+        }
+        serial_tx_fill();
+    }
+
+    if (rx_waiters != 0 || tx_waiters != 0 || poll_waiters != 0)
+        wake_all_terminals();
+    send_eoi(SERIAL_IRQ);
+}
+
+/*
+ * serial_klog_putc
+ * description:
+ * console sink for the kernel log, never sleeps. When the ring is full
+ * the oldest byte is sent by polling to make room
+ * input: c -- the byte to send
+ * output: none
+ */
+void serial_klog_putc(uint8_t c)
+{
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if (c == '\n')
+    {
+        while (serial_tx_push('\r') == -1)
+        {
+            serial_putc_polled(tx_ring[tx_tail]);
+            tx_tail = (tx_tail + 1) % SERIAL_TX_SIZE;
+        }
+    }
+    while (serial_tx_push(c) == -1)
+    {
+        serial_putc_polled(tx_ring[tx_tail]);
+        tx_tail = (tx_tail + 1) % SERIAL_TX_SIZE;
+    }
+    serial_tx_fill();
+    restore_flags(flags);
+}
+
+/*
+ * serial_read
+ * description:
+ * read what has arrived on COM1, waiting in hlt until at least one byte is
+ * there unless the descriptor is O_NONBLOCK
+ * input: fd -- the serial descriptor
+ *        buf -- where to put the bytes
+ *        nbytes -- the most bytes to read
+ * output: the number of bytes read, -1 on failure, -EAGAIN when nothing
+ *         arrived and the descriptor is O_NONBLOCK
+ */
+int32_t serial_read(int32_t fd, void *buf, int32_t nbytes)
+{
+    uint32_t flags;
+    int32_t count = 0;
+    uint8_t *dest = (uint8_t *)buf;
+
+    if (buf == NULL || nbytes < 0)
+        return -1;
+    if (nbytes == 0)
+        return 0;
+
+    cli_and_save(flags);
+    if ((get_pcb()->descriptors[fd].f_status & O_NONBLOCK) && rx_head == rx_tail)
+    {
+        restore_flags(flags);
+        return -EAGAIN;
+    }
+    rx_waiters++;
+    while (rx_head == rx_tail)
+    {
+        if (signal_kill_pending())
+        {
+            rx_waiters--;
+            restore_flags(flags);
+            return -1;
+        }
+        idle_wait();
+    }
+    rx_waiters--;
+
+    while (count < nbytes && rx_head != rx_tail)
+    {
+        dest[count++] = rx_ring[rx_tail];
+        rx_tail = (rx_tail + 1) % SERIAL_RX_SIZE;
+    }
+    restore_flags(flags);
+    return count;
+}
+
+/*
+ * serial_write
+ * description:
+ * queue bytes for COM1, waiting in hlt while the transmit ring is full
+ * input: fd -- not used
+ *        buf -- the bytes to send
+ *        nbytes -- how many
+ * output: the number of bytes written, -1 on failure
+ */
+int32_t serial_write(int32_t fd, const void *buf, int32_t nbytes)
+{
+    uint32_t flags;
+    int32_t count = 0;
+    const uint8_t *src = (const uint8_t *)buf;
+
+    if (buf == NULL || nbytes < 0)
+        return -1;
+
+    cli_and_save(flags);
+    tx_waiters++;
+    while (count < nbytes)
+    {
+        if (serial_tx_push(src[count]) == 0)
+        {
+            count++;
+            continue;
+        }
+        // full, start the transmitter and wait for room
+        serial_tx_fill();
+        if (signal_kill_pending())
+            break;
+        idle_wait();
+    }
+    tx_waiters--;
+    serial_tx_fill();
+    restore_flags(flags);
+    return count;
+}
+
+/*
+ * serial_poll
+ * description:
+ * the poll entry of COM1
+ * input: fd -- not used
+ * output: POLLIN when bytes have arrived, POLLOUT when the transmit ring has
+ *         room
+ */
+int32_t serial_poll(int32_t fd)
+{
+    int32_t events = 0;
+
+    if (rx_head != rx_tail)
+        events |= POLLIN;
+    if ((tx_head + 1) % SERIAL_TX_SIZE != tx_tail)
+        events |= POLLOUT;
+    return events;
+}
+
+/*
+ * serial_open
+ * description:
+ * nothing to set up, the port is initialized at boot
+ * input: filename -- not used
+ * output: always 0
+ */
+int32_t serial_open(const uint8_t *filename)
+{
+    return 0;
+}
+
+/*
+ * serial_close
+ * description:
+ * nothing to tear down
+ * input: fd -- not used
+ * output: always 0
+ */
+int32_t serial_close(int32_t fd)
+{
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include "lib.h"
+#include "types.h"
+#include "i8259.h"
+#include "poll.h"
+
+// COM1 16550 UART registers, offsets from the base port
+#define COM1_PORT           0x3F8
+#define UART_DATA           0
+#define UART_IER            1
+#define UART_FCR            2
+#define UART_LCR            3
+#define UART_MCR            4
+#define UART_IIR            2
+#define UART_LSR            5
+#define UART_DLL            0
+#define UART_DLM            1
+
+// 115200 baud, 8 data bits, no parity, one stop bit
+#define UART_DIVISOR        1
+#define UART_LCR_DLAB       0x80
+#define UART_LCR_8N1        0x03
+// enable and clear the FIFOs, interrupt at 14 bytes
+#define UART_FCR_ENABLE     0xC7
+// DTR, RTS and OUT2, OUT2 routes the interrupt to the PIC
+#define UART_MCR_ON         0x0B
+#define UART_LSR_THRE       0x20
+#define UART_LSR_DR         0x01
+#define UART_IIR_NONE       0x01
+// receive data and transmitter empty interrupts
+#define UART_IER_RX         0x01
+#define UART_IER_TX         0x02
+#define UART_FIFO_SIZE      16
+
+#define SERIAL_IRQ          4
+// the name open() takes for the port
+#define SERIAL_DEVICE_NAME  "ttyS0"
+#define SERIAL_TX_SIZE      4096
+#define SERIAL_RX_SIZE      256
+
+extern void serial_init();
+extern void serial_putc_polled(uint8_t c);
+extern void serial_puts_polled(const int8_t *s);
+extern void serial_handler();
+extern void serial_klog_putc(uint8_t c);
+extern int32_t serial_read(int32_t fd, void *buf, int32_t nbytes);
+extern int32_t serial_write(int32_t fd, const void *buf, int32_t nbytes);
+extern int32_t serial_open(const uint8_t *filename);
+extern int32_t serial_close(int32_t fd);
+extern int32_t serial_poll(int32_t fd);
+
+#endif
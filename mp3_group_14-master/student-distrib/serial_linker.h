@@ -0,0 +1,6 @@
+/* serial_linker.h - Header for the serial port linker */
+#include "serial.h"
+
+
+/* Pointer to assembly linker. */
+extern void serial_linker();
@@ -0,0 +1,164 @@
+#include "signal.h"
+#include "pcb.h"
+#include "do_sys.h"
+#include "schedule.h"
+
+// PIT ticks since the last ALARM
+static uint32_t alarm_count = 0;
+
+/*
+ * send_signal
+ *   DESCRIPTION: mark a signal pending on a process, it is handled the
+ *                next time the process returns to user space
+ *   INPUTS: uint32_t pid -- the process to signal
+ *           int32_t signum -- the signal to send
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void send_signal(uint32_t pid, int32_t signum)
+{
+  if (pid >= MAX_PROCESS_NUM || signum < 0 || signum >= NUM_SIGNALS) return;
+  if (process[pid] == PROCESS_OFF) return;
+  get_pcb_by_pid(pid)->sig_pending |= SIGNAL_BIT(signum);
+  // a process sleeping in a read must run to notice the signal
+  wake_terminal(get_pcb_by_pid(pid)->terminal_id);
+}
+
+/*
+ * fault_signal
+ *   DESCRIPTION: signal the current process for an exception it took in
+ *                user space, a fault inside the handler of the same signal
+ *                cannot be delivered again and kills the process
+ *   INPUTS: int32_t signum -- the signal for the exception
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: may halt the current process
+ */
+void fault_signal(int32_t signum)
+{
+  pcb_t *current_pcb = get_pcb();
+
+  if (current_pcb->sig_masked & SIGNAL_BIT(signum)) halt_process(HALT_BY_SIGNAL);
+  current_pcb->sig_pending |= SIGNAL_BIT(signum);
+}
+
+/*
+ * signal_kill_pending
+ *   DESCRIPTION: check whether the current process has a signal waiting
+ *                that kills it, used by blocking reads to give up early.
+ *                Signals with a handler wait until the read returns
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if a pending signal kills the process, 0 otherwise
+ *   SIDE EFFECTS: none
+ */
+int32_t signal_kill_pending()
+{
+  int32_t signum;
+  pcb_t *current_pcb = get_pcb();
+
+  for (signum = DIV_ZERO; signum <= INTERRUPT; signum++)
+  {
+    if ((current_pcb->sig_pending & ~current_pcb->sig_masked & SIGNAL_BIT(signum)) &&
+        current_pcb->sig_handlers[signum] == NULL) return 1;
+  }
+  return 0;
+}
+
+/*
+ * alarm_tick
+ *   DESCRIPTION: called from the PIT interrupt, sends ALARM to the active
+ *                process of every terminal once every ALARM_TICKS ticks
+ *   INPUTS: uint32_t ticks -- 100HZ ticks since the last call, more than
+ *                             one after a tickless sleep
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void alarm_tick(uint32_t ticks)
+{
+  int32_t i;
+
+  alarm_count += ticks;
+  if (alarm_count < ALARM_TICKS) return;
+  alarm_count %= ALARM_TICKS;
+  for (i = 0; i < MAX_TERMINAL_NUM; i++)
+    send_signal(terminals[i].current_pid, ALARM);
+}
+
+/*
+ * alarm_ticks_left
+ *   DESCRIPTION: the next deadline of the PIT driven timers
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: 100HZ ticks until the next ALARM
+ *   SIDE EFFECTS: none
+ */
+uint32_t alarm_ticks_left()
+{
+  return ALARM_TICKS - alarm_count;
+}
+
+/*
+ * do_signal
+ *   DESCRIPTION: called by every linker before returning to user space,
+ *                handle the lowest pending signal of the current process.
+ *                A user handler gets a frame on the user stack holding a
+ *                sigreturn trampoline, the saved registers, the signal
+ *                number and a return address into the trampoline
+ *   INPUTS: hw_context_t *regs -- the registers saved by the linker
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: may rewrite regs to enter the handler or halt the process
+ */
+void do_signal(hw_context_t *regs)
+{
+  int32_t signum;
+  uint32_t user_esp;
+  uint8_t *trampoline;
+  uint32_t *frame;
+  pcb_t *current_pcb;
+
+  // signals are only handled on the way back to user space
+  if ((regs->cs & USER_RPL) != USER_RPL) return;
+
+  current_pcb = get_pcb();
+  for (signum = 0; signum < NUM_SIGNALS; signum++)
+  {
+    if (current_pcb->sig_pending & ~current_pcb->sig_masked & SIGNAL_BIT(signum)) break;
+  }
+  if (signum == NUM_SIGNALS) return;
+  current_pcb->sig_pending &= ~SIGNAL_BIT(signum);
+
+  // default actions, the faults and INTERRUPT kill, ALARM and USER1 are ignored
+  if (current_pcb->sig_handlers[signum] == NULL)
+  {
+    if (signum == DIV_ZERO || signum == SEGFAULT || signum == INTERRUPT) halt_process(HALT_BY_SIGNAL);
+    return;
+  }
+
+  // the frame must fit on the mapped user stack, growing it if needed
+  user_esp = regs->esp - TRAMPOLINE_SIZE - sizeof(hw_context_t) - 2 * sizeof(uint32_t);
+  if (user_esp > regs->esp || !user_ptr_valid((void *)(regs->esp - 1))) halt_process(HALT_BY_SIGNAL);
+  if (!user_range_valid((void *)user_esp, regs->esp - user_esp)) halt_process(HALT_BY_SIGNAL);
+
+  // movl $SIGRETURN_CALL, %eax; int $0x80; nop
+  trampoline = (uint8_t *)(regs->esp - TRAMPOLINE_SIZE);
+  trampoline[0] = OP_MOVL_EAX;
+  *(uint32_t *)(trampoline + 1) = SIGRETURN_CALL;
+  trampoline[5] = OP_INT;
+  trampoline[6] = SYSCALL_VECTOR;
+  trampoline[7] = OP_NOP;
+
+  // saved registers, then the argument and the return address of the handler
+  memcpy(trampoline - sizeof(hw_context_t), regs, sizeof(hw_context_t));
+  frame = (uint32_t *)user_esp;
+  frame[0] = (uint32_t)trampoline;
+  frame[1] = signum;
+
+  // no other signal is delivered until the handler calls sigreturn
+  current_pcb->sig_masked = SIG_MASK_ALL;
+  regs->esp = user_esp;
+  regs->return_address = (uint32_t)current_pcb->sig_handlers[signum];
+}
@@ -0,0 +1,73 @@
+#ifndef SIGNAL_H
+#define SIGNAL_H
+
+#include "types.h"
+
+// signal numbers, the same as enum signums in ece391syscall.h
+#define DIV_ZERO            0
+#define SEGFAULT            1
+#define INTERRUPT           2
+#define ALARM               3
+#define USER1               4
+#define NUM_SIGNALS         5
+
+#define SIGNAL_BIT(signum)  (1 << (signum))
+#define SIG_MASK_ALL        0x1F
+
+// status a parent sees when its child is killed by a signal
+#define HALT_BY_SIGNAL      256
+
+// ALARM is sent every 10 seconds of 100HZ PIT ticks
+#define ALARM_TICKS         1000
+
+// the trampoline is "movl $10, %eax; int $0x80" padded to 8 bytes
+#define SIGRETURN_CALL      10
+#define TRAMPOLINE_SIZE     8
+#define OP_MOVL_EAX         0xB8
+#define OP_INT              0xCD
+#define OP_NOP              0x90
+#define SYSCALL_VECTOR      0x80
+
+// privilege level of a frame that came from user space
+#define USER_RPL            0x3
+
+// flags a handler may change, CF PF AF ZF SF DF OF, and the IF flag
+#define USER_EFLAGS_MASK    0x00000CD5
+#define EFLAGS_IF           0x00000200
+
+/* the registers saved on the kernel stack by every linker, lowest address
+ * first, and the frame copied to the user stack for a signal handler */
+typedef struct hw_context {
+  uint32_t ebx;
+  uint32_t ecx;
+  uint32_t edx;
+  uint32_t esi;
+  uint32_t edi;
+  uint32_t ebp;
+  uint32_t eax;
+  uint32_t ds;
+  uint32_t es;
+  uint32_t fs;
+  // the error code, the irq number or the system call number
+  uint32_t irq_exp;
+  // pushed by the processor
+  uint32_t return_address;
+  uint32_t cs;
+  uint32_t eflags;
+  uint32_t esp;
+  uint32_t ss;
+} hw_context_t;
+
+void send_signal(uint32_t pid, int32_t signum);
+
+void fault_signal(int32_t signum);
+
+int32_t signal_kill_pending();
+
+void alarm_tick(uint32_t ticks);
+
+uint32_t alarm_ticks_left();
+
+void do_signal(hw_context_t *regs);
+
+#endif
@@ -0,0 +1,296 @@
+#include "smp.h"
+#include "ap_boot.h"
+#include "lib.h"
+#include "clock.h"
+#include "x86_desc.h"
+
+// the processors the MP table lists, the boot processor among them
+static cpu_t cpus[MAX_CPUS];
+static uint32_t cpu_count = 0;
+// 0 when there is no MP table, and so only the boot processor
+static uint32_t lapic_base = 0;
+
+// read by ap_start32 before it turns paging on
+volatile uint32_t ap_boot_cr3;
+volatile uint32_t ap_boot_stack;
+// the processor being started, and whether it made it to ap_main
+static volatile uint32_t ap_boot_cpu;
+static volatile uint32_t ap_started;
+
+static uint8_t ap_stacks[MAX_CPUS][AP_STACK_SIZE] __attribute__((aligned (AP_STACK_SIZE)));
+
+/*
+ * mp_checksum
+ *   DESCRIPTION: MP structures are valid when their bytes add up to 0
+ *   INPUTS: uint8_t *p -- the structure
+ *           uint32_t length -- its size in bytes
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 if the checksum is right
+ *   SIDE EFFECTS: none
+ */
+static uint8_t mp_checksum(uint8_t *p, uint32_t length)
+{
+  uint8_t sum = 0;
+  uint32_t i;
+
+  for (i = 0; i < length; i++)
+    sum += p[i];
+  return sum;
+}
+
+/*
+ * mp_search
+ *   DESCRIPTION: look for the MP floating pointer in a range of memory
+ *   INPUTS: uint32_t start -- physical address to start at
+ *           uint32_t length -- bytes to search
+ *   OUTPUTS: none
+ *   RETURN VALUE: the floating pointer, NULL if it is not there
+ *   SIDE EFFECTS: none
+ */
+static mp_float_t *mp_search(uint32_t start, uint32_t length)
+{
+  uint32_t addr;
+  mp_float_t *mp;
+
+  for (addr = start; addr + sizeof(mp_float_t) <= start + length; addr += MP_ALIGN)
+  {
+    mp = (mp_float_t *)addr;
+    if (mp->signature == MP_FLOAT_SIG && mp_checksum((uint8_t *)mp, sizeof(mp_float_t)) == 0)
+      return mp;
+  }
+  return NULL;
+}
+
+/*
+ * smp_detect
+ *   DESCRIPTION: find the processors in the MP configuration table and
+ *                copy the trampoline they start in below 1MB. Must run
+ *                before paging, which leaves low memory unmapped
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: without an MP table only the boot processor is used
+ */
+void smp_detect()
+{
+  mp_float_t *mp;
+  mp_config_t *config;
+  mp_processor_t *proc;
+  uint8_t *entry;
+  uint32_t i;
+
+  // the boot processor, whatever the table says
+  cpus[0].bsp = 1;
+  cpus[0].online = 1;
+  cpu_count = 1;
+
+  mp = mp_search((uint32_t)*(uint16_t *)BDA_EBDA_SEGMENT << 4, MP_SEARCH_KB);
+  if (mp == NULL) mp = mp_search(BASE_MEM_LAST_KB, MP_SEARCH_KB);
+  if (mp == NULL) mp = mp_search(BIOS_ROM_ADDR, BIOS_ROM_SIZE);
+  if (mp == NULL || mp->config == 0) return;
+
+  config = (mp_config_t *)mp->config;
+  if (config->signature != MP_CONFIG_SIG || mp_checksum((uint8_t *)config, config->length) != 0)
+    return;
+  // the local APIC has to be in the page paging.c maps for it
+  if ((config->lapic_addr >> PDE_SHIFT) != (APIC_MMIO_ADDR >> PDE_SHIFT))
+    return;
+
+  cpu_count = 0;
+  entry = (uint8_t *)(config + 1);
+  for (i = 0; i < config->entry_count; i++)
+  {
+    if (*entry != MP_PROCESSOR)
+    {
+      entry += MP_ENTRY_SIZE;
+      continue;
+    }
+    proc = (mp_processor_t *)entry;
+    entry += MP_PROCESSOR_SIZE;
+    if (!(proc->flags & MP_CPU_ENABLED) || cpu_count == MAX_CPUS)
+      continue;
+    cpus[cpu_count].apic_id = proc->apic_id;
+    cpus[cpu_count].bsp = (proc->flags & MP_CPU_BSP) ? 1 : 0;
+    cpus[cpu_count].online = cpus[cpu_count].bsp;
+    cpu_count++;
+  }
+  if (cpu_count == 0)
+  {
+    cpus[0].bsp = 1;
+    cpus[0].online = 1;
+    cpu_count = 1;
+    return;
+  }
+  lapic_base = config->lapic_addr;
+
+  memcpy((void *)AP_TRAMPOLINE_ADDR, ap_trampoline, ap_trampoline_end - ap_trampoline);
+  memcpy((void *)(AP_TRAMPOLINE_ADDR + (ap_gdt_desc - ap_trampoline)), &gdt_desc, sizeof(uint16_t) + sizeof(uint32_t));
+}
+
+/*
+ * lapic_read
+ *   DESCRIPTION: read a local APIC register of this processor
+ *   INPUTS: uint32_t reg -- the register offset
+ *   OUTPUTS: none
+ *   RETURN VALUE: the value of the register
+ *   SIDE EFFECTS: none
+ */
+static uint32_t lapic_read(uint32_t reg)
+{
+  return *(volatile uint32_t *)(lapic_base + reg);
+}
+
+/*
+ * lapic_write
+ *   DESCRIPTION: write a local APIC register of this processor
+ *   INPUTS: uint32_t reg -- the register offset
+ *           uint32_t value -- what to write
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+static void lapic_write(uint32_t reg, uint32_t value)
+{
+  *(volatile uint32_t *)(lapic_base + reg) = value;
+}
+
+/*
+ * lapic_ipi
+ *   DESCRIPTION: send an interprocessor interrupt and wait until the
+ *                local APIC has delivered it
+ *   INPUTS: uint32_t apic_id -- the processor to send to
+ *           uint32_t command -- the low word of the command register
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+static void lapic_ipi(uint32_t apic_id, uint32_t command)
+{
+  lapic_write(LAPIC_ICR_HIGH, apic_id << LAPIC_ID_SHIFT);
+  lapic_write(LAPIC_ICR_LOW, command);
+  while (lapic_read(LAPIC_ICR_LOW) & ICR_PENDING);
+}
+
+/*
+ * smp_delay
+ *   DESCRIPTION: spin on the TSC clock
+ *   INPUTS: uint32_t us -- how long, in microseconds
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+static void smp_delay(uint32_t us)
+{
+  uint64_t end = clock_ns() + (uint64_t)us * NS_PER_US;
+  while (clock_ns() < end);
+}
+
+/*
+ * smp_init
+ *   DESCRIPTION: start every other processor with INIT-SIPI-SIPI. They
+ *                come up on the kernel page directory and their own
+ *                stacks, and park in ap_main. Needs the TSC clock
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: busy-waits about 10ms per processor
+ */
+void smp_init()
+{
+  uint32_t i;
+  uint64_t deadline;
+
+  if (lapic_base == 0 || cpu_count < 2) return;
+
+  lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS);
+  asm volatile("movl %%cr3, %0" : "=r"(ap_boot_cr3));
+
+  for (i = 0; i < cpu_count; i++)
+  {
+    if (cpus[i].bsp) continue;
+    ap_boot_cpu = i;
+    ap_boot_stack = (uint32_t)&ap_stacks[i][AP_STACK_SIZE];
+    ap_started = 0;
+
+    lapic_ipi(cpus[i].apic_id, ICR_INIT);
+    smp_delay(INIT_DELAY_US);
+    lapic_ipi(cpus[i].apic_id, ICR_STARTUP | (AP_TRAMPOLINE_ADDR >> PAGE_SHIFT));
+    smp_delay(SIPI_DELAY_US);
+    if (!ap_started)
+      lapic_ipi(cpus[i].apic_id, ICR_STARTUP | (AP_TRAMPOLINE_ADDR >> PAGE_SHIFT));
+
+    // the stack and ap_boot_cpu are in use until it is up
+    deadline = clock_ns() + (uint64_t)AP_START_TIMEOUT_US * NS_PER_US;
+    while (!ap_started && clock_ns() < deadline);
+  }
+}
+
+/*
+ * ap_main
+ *   DESCRIPTION: where an application processor arrives from ap_start32.
+ *                The scheduler, get_pcb, the terminals and the devices
+ *                all still assume a single processor, so it only reports
+ *                that it is online and parks with interrupts off
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: never returns
+ *   SIDE EFFECTS: none
+ */
+void ap_main()
+{
+  lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS);
+  cpus[ap_boot_cpu].online = 1;
+  ap_started = 1;
+
+  while (1)
+    asm volatile("cli; hlt");
+}
+
+/*
+ * smp_cpu_count
+ *   DESCRIPTION: the number of processors found
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: at least 1
+ *   SIDE EFFECTS: none
+ */
+uint32_t smp_cpu_count()
+{
+  return cpu_count;
+}
+
+/*
+ * smp_online_count
+ *   DESCRIPTION: the number of processors that are running
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: at least 1
+ *   SIDE EFFECTS: none
+ */
+uint32_t smp_online_count()
+{
+  uint32_t i, online = 0;
+
+  for (i = 0; i < cpu_count; i++)
+    online += cpus[i].online;
+  return online;
+}
+
+/*
+ * smp_this_cpu
+ *   DESCRIPTION: the processor this runs on, found by its local APIC id
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: the cpu, the boot processor without an MP table
+ *   SIDE EFFECTS: none
+ */
+cpu_t *smp_this_cpu()
+{
+  uint32_t i, apic_id;
+
+  if (lapic_base == 0) return &cpus[0];
+  apic_id = lapic_read(LAPIC_ID) >> LAPIC_ID_SHIFT;
+  for (i = 0; i < cpu_count; i++)
+    if (cpus[i].apic_id == apic_id) return &cpus[i];
+  return &cpus[0];
+}
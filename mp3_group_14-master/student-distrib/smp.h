@@ -0,0 +1,117 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "types.h"
+
+// the application processors start in real mode at this page, below 1MB
+#define AP_TRAMPOLINE_ADDR  0x8000
+#define AP_STACK_SIZE       4096
+#define MAX_CPUS            8
+
+// control register bits the trampoline sets
+#define CR0_PE              0x00000001
+#define CR0_PG              0x80000000
+#define CR0_WP              0x00010000
+#define CR4_PSE             0x00000010
+
+#ifndef ASM
+
+// where the BIOS may put the MP floating pointer
+#define BDA_EBDA_SEGMENT    0x40E
+#define BASE_MEM_LAST_KB    0x9FC00
+#define BIOS_ROM_ADDR       0xF0000
+#define BIOS_ROM_SIZE       0x10000
+#define MP_SEARCH_KB        0x400
+#define MP_ALIGN            16
+
+#define MP_FLOAT_SIG        0x5F504D5F  /* "_MP_" */
+#define MP_CONFIG_SIG       0x504D4350  /* "PCMP" */
+#define MP_PROCESSOR        0
+#define MP_PROCESSOR_SIZE   20
+#define MP_ENTRY_SIZE       8
+#define MP_CPU_ENABLED      0x01
+#define MP_CPU_BSP          0x02
+
+// local APIC registers, offsets from the base the MP table gives
+#define LAPIC_ID            0x020
+#define LAPIC_SVR           0x0F0
+#define LAPIC_ICR_LOW       0x300
+#define LAPIC_ICR_HIGH      0x310
+#define LAPIC_ID_SHIFT      24
+#define LAPIC_SVR_ENABLE    0x100
+#define LAPIC_SPURIOUS      0xFF
+#define ICR_INIT            0x00004500
+#define ICR_STARTUP         0x00004600
+#define ICR_PENDING         0x00001000
+#define PAGE_SHIFT          12
+
+// the IOAPIC and local APIC share this 4MB page, see paging.c
+#define APIC_MMIO_ADDR      0xFEC00000
+#define PDE_SHIFT           22
+
+// waits of the INIT-SIPI-SIPI sequence, in microseconds
+#define INIT_DELAY_US       10000
+#define SIPI_DELAY_US       200
+#define AP_START_TIMEOUT_US 100000
+#define NS_PER_US           1000
+
+/* the MP floating pointer structure */
+typedef struct mp_float {
+  uint32_t signature;
+  uint32_t config;
+  uint8_t length;
+  uint8_t spec_rev;
+  uint8_t checksum;
+  uint8_t features[5];
+} __attribute__((packed)) mp_float_t;
+
+/* the header of the MP configuration table */
+typedef struct mp_config {
+  uint32_t signature;
+  uint16_t length;
+  uint8_t spec_rev;
+  uint8_t checksum;
+  uint8_t oem_id[8];
+  uint8_t product_id[12];
+  uint32_t oem_table;
+  uint16_t oem_table_size;
+  uint16_t entry_count;
+  uint32_t lapic_addr;
+  uint16_t ext_length;
+  uint8_t ext_checksum;
+  uint8_t reserved;
+} __attribute__((packed)) mp_config_t;
+
+/* a processor entry of the MP configuration table */
+typedef struct mp_processor {
+  uint8_t type;
+  uint8_t apic_id;
+  uint8_t apic_version;
+  uint8_t flags;
+  uint32_t signature;
+  uint32_t features;
+  uint32_t reserved[2];
+} __attribute__((packed)) mp_processor_t;
+
+/* one processor */
+typedef struct cpu {
+  uint32_t apic_id;
+  uint32_t bsp;
+  volatile uint32_t online;
+} cpu_t;
+
+void smp_detect();
+
+void smp_init();
+
+void ap_main();
+
+uint32_t smp_cpu_count();
+
+uint32_t smp_online_count();
+
+cpu_t *smp_this_cpu();
+
+#endif /* ASM */
+
+#endif
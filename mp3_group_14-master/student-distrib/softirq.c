@@ -0,0 +1,82 @@
+#include "softirq.h"
+#include "lib.h"
+#include "spinlock.h"
+
+static softirq_handler_t softirq_handlers[SOFTIRQ_MAX];
+static volatile uint32_t softirq_pending = 0;
+static volatile uint32_t softirq_running = 0;
+
+/*
+ * softirq_register
+ *   DESCRIPTION: set the bottom half that runs for a softirq
+ *   INPUTS: uint32_t nr -- the softirq, one of the SOFTIRQ_ numbers
+ *           softirq_handler_t handler -- the bottom half
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void softirq_register(uint32_t nr, softirq_handler_t handler)
+{
+  if (nr >= SOFTIRQ_MAX) return;
+  softirq_handlers[nr] = handler;
+}
+
+/*
+ * softirq_raise
+ *   DESCRIPTION: called by an interrupt handler that left work for its
+ *                bottom half, which runs on the way out of the interrupt
+ *   INPUTS: uint32_t nr -- the softirq
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void softirq_raise(uint32_t nr)
+{
+  if (nr >= SOFTIRQ_MAX) return;
+  asm volatile("lock orl %1, %0" : "+m"(softirq_pending) : "r"(1 << nr) : "memory", "cc");
+}
+
+/*
+ * do_softirq
+ *   DESCRIPTION: called by interrupt_return, run the pending bottom halves
+ *                with interrupts on. Not while the interrupted code had
+ *                interrupts off, holds a lock or is already in here, the
+ *                next interrupt or system call return after that runs
+ *                them. No switch to another terminal happens in a bottom
+ *                half
+ *   INPUTS: hw_context_t *regs -- the frame being returned to
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: returns with the interrupt flag it was called with
+ */
+void do_softirq(hw_context_t *regs)
+{
+  uint32_t flags, pending, nr;
+
+  if (!(regs->eflags & EFLAGS_IF)) return;
+
+  cli_and_save(flags);
+  if (softirq_running || preempt_disabled() || softirq_pending == 0)
+  {
+    restore_flags(flags);
+    return;
+  }
+  softirq_running = 1;
+  preempt_disable();
+
+  // an interrupt during the bottom halves may raise another
+  while (softirq_pending != 0)
+  {
+    pending = 0;
+    asm volatile("xchgl %0, %1" : "+r"(pending), "+m"(softirq_pending) : : "memory");
+    sti();
+    for (nr = 0; nr < SOFTIRQ_MAX; nr++)
+      if ((pending & (1 << nr)) && softirq_handlers[nr] != NULL)
+        softirq_handlers[nr]();
+    cli();
+  }
+
+  preempt_enable();
+  softirq_running = 0;
+  restore_flags(flags);
+}
@@ -0,0 +1,19 @@
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include "types.h"
+#include "signal.h"
+
+// the deferred work, one bit of softirq_pending each
+#define SOFTIRQ_KEYBOARD    0
+#define SOFTIRQ_MAX         32
+
+typedef void (*softirq_handler_t)();
+
+void softirq_register(uint32_t nr, softirq_handler_t handler);
+
+void softirq_raise(uint32_t nr);
+
+void do_softirq(hw_context_t *regs);
+
+#endif
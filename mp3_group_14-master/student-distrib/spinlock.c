@@ -0,0 +1,207 @@
+#include "spinlock.h"
+#include "lib.h"
+#include "clock.h"
+#include "serial.h"
+
+// sections that must not be switched away from, see pit_handler. One
+// count is enough while the other processors stay parked
+static volatile uint32_t preempt_count = 0;
+
+// every lock taken so far, in the order they were first taken
+static spinlock_t *spinlocks[SPINLOCK_MAX];
+static uint32_t spinlock_count = 0;
+
+/*
+ * preempt_disable
+ *   DESCRIPTION: keep the scheduler from switching to another terminal
+ *                until the matching preempt_enable. Interrupts still run
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: nests
+ */
+void preempt_disable()
+{
+  preempt_count++;
+  asm volatile("" : : : "memory");
+}
+
+/*
+ * preempt_enable
+ *   DESCRIPTION: undo one preempt_disable. A switch held off in between
+ *                happens on the next PIT tick
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void preempt_enable()
+{
+  asm volatile("" : : : "memory");
+  preempt_count--;
+}
+
+/*
+ * preempt_disabled
+ *   DESCRIPTION: whether the running code may be switched away from
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: nonzero inside a preempt_disable or a held lock
+ *   SIDE EFFECTS: none
+ */
+uint32_t preempt_disabled()
+{
+  return preempt_count;
+}
+
+/*
+ * spin_register
+ *   DESCRIPTION: add a lock to the ones spin_stats_dump lists
+ *   INPUTS: spinlock_t *lock -- a lock taken for the first time
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: locks past SPINLOCK_MAX are counted but not listed
+ */
+static void spin_register(spinlock_t *lock)
+{
+  uint32_t flags;
+
+  cli_and_save(flags);
+  if (!lock->registered && spinlock_count < SPINLOCK_MAX)
+    spinlocks[spinlock_count++] = lock;
+  lock->registered = 1;
+  restore_flags(flags);
+}
+
+/*
+ * spin_lock
+ *   DESCRIPTION: take a lock, spinning until its holder lets go, and
+ *                start timing how long it is held. No switch happens while
+ *                it is held, so a holder is never left stranded. A lock
+ *                that an interrupt handler takes must use spin_lock_irqsave
+ *   INPUTS: spinlock_t *lock -- the lock
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: disables preemption
+ */
+void spin_lock(spinlock_t *lock)
+{
+  uint32_t taken = 1;
+
+  preempt_disable();
+  asm volatile("xchgl %0, %1" : "+r"(taken), "+m"(lock->locked) : : "memory");
+  if (taken)
+  {
+    lock->contended++;
+    do
+    {
+      while (lock->locked)
+        asm volatile("pause");
+      taken = 1;
+      asm volatile("xchgl %0, %1" : "+r"(taken), "+m"(lock->locked) : : "memory");
+    } while (taken);
+  }
+
+  if (!lock->registered)
+    spin_register(lock);
+  lock->acquired++;
+  lock->start = rdtsc();
+}
+
+/*
+ * spin_unlock
+ *   DESCRIPTION: account the time the lock was held and let it go
+ *   INPUTS: spinlock_t *lock -- a lock taken with spin_lock
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: enables preemption again
+ */
+void spin_unlock(spinlock_t *lock)
+{
+  uint64_t held = rdtsc() - lock->start;
+  uint32_t free = 0;
+
+  if (held > lock->max_hold)
+    lock->max_hold = held;
+  lock->total_hold += held;
+
+  asm volatile("xchgl %0, %1" : "+r"(free), "+m"(lock->locked) : : "memory");
+  preempt_enable();
+}
+
+/*
+ * spin_lock_irqsave
+ *   DESCRIPTION: take a lock with interrupts off on this processor, for
+ *                data an interrupt handler also touches. Its hold time is
+ *                then the time interrupts were held off
+ *   INPUTS: spinlock_t *lock -- the lock
+ *   OUTPUTS: none
+ *   RETURN VALUE: the flags to give to spin_unlock_irqrestore
+ *   SIDE EFFECTS: disables interrupts and preemption
+ */
+uint32_t spin_lock_irqsave(spinlock_t *lock)
+{
+  uint32_t flags;
+
+  cli_and_save(flags);
+  spin_lock(lock);
+  return flags;
+}
+
+/*
+ * spin_unlock_irqrestore
+ *   DESCRIPTION: let go of a lock taken with spin_lock_irqsave and put the
+ *                interrupt flag back the way it was
+ *   INPUTS: spinlock_t *lock -- the lock
+ *           uint32_t flags -- what spin_lock_irqsave returned
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: may enable interrupts
+ */
+void spin_unlock_irqrestore(spinlock_t *lock, uint32_t flags)
+{
+  spin_unlock(lock);
+  restore_flags(flags);
+}
+
+/*
+ * spin_stats_dump
+ *   DESCRIPTION: send the lock statistics over COM1, one
+ *                "name acquired contended max avg" line per lock, the
+ *                hold times in TSC cycles, after a header giving the rate
+ *   INPUTS: none
+ *   OUTPUTS: the statistics on the serial port
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: busy-waits on the UART
+ */
+void spin_stats_dump()
+{
+  uint32_t i;
+  uint64_t max;
+  spinlock_t *lock;
+  int8_t buf[SPINLOCK_LINE_SIZE];
+
+  serial_puts_polled("# locks tsc_khz=");
+  serial_puts_polled(itoa(clock_tsc_khz(), buf, 10));
+  serial_puts_polled("\n");
+
+  for (i = 0; i < spinlock_count; i++)
+  {
+    lock = spinlocks[i];
+    // past 32 bits a hold is far too long anyway, print it saturated
+    max = lock->max_hold;
+    if (max > 0xFFFFFFFF) max = 0xFFFFFFFF;
+
+    serial_puts_polled(lock->name);
+    serial_puts_polled(" ");
+    serial_puts_polled(itoa(lock->acquired, buf, 10));
+    serial_puts_polled(" ");
+    serial_puts_polled(itoa(lock->contended, buf, 10));
+    serial_puts_polled(" ");
+    serial_puts_polled(itoa((uint32_t)max, buf, 10));
+    serial_puts_polled(" ");
+    serial_puts_polled(itoa((uint32_t)div64_32(lock->total_hold, lock->acquired, NULL), buf, 10));
+    serial_puts_polled("\n");
+  }
+  serial_puts_polled("# end\n");
+}
@@ -0,0 +1,40 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include "types.h"
+
+// at most this many locks are listed by a dump
+#define SPINLOCK_MAX        16
+#define SPINLOCK_LINE_SIZE  24
+
+/* a lock, and how long it has been held, in TSC cycles */
+typedef struct spinlock {
+  volatile uint32_t locked;
+  const int8_t *name;
+  uint32_t registered;
+  uint32_t acquired;      /* times it was taken */
+  uint32_t contended;     /* times it had to spin first */
+  uint64_t start;         /* TSC when it was taken */
+  uint64_t max_hold;
+  uint64_t total_hold;
+} spinlock_t;
+
+#define SPINLOCK_INIT(lock_name)    { 0, lock_name, 0, 0, 0, 0, 0, 0 }
+
+void preempt_disable();
+
+void preempt_enable();
+
+uint32_t preempt_disabled();
+
+void spin_lock(spinlock_t *lock);
+
+void spin_unlock(spinlock_t *lock);
+
+uint32_t spin_lock_irqsave(spinlock_t *lock);
+
+void spin_unlock_irqrestore(spinlock_t *lock, uint32_t flags);
+
+void spin_stats_dump();
+
+#endif
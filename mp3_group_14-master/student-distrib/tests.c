@@ -1,4 +1,9 @@
 #include "tests.h"
+#include "kthread.h"
+#include "workqueue.h"
+#include "prezero.h"
+#include "thread.h"
+#include "vdso.h"
 
 #define PASS 1
 #define FAIL 0
@@ -656,6 +661,503 @@ int test_vidmap_fail(){
 	return FAIL;
 }
 
+/* 
+ * test_mmap_fail
+ * description: 
+ * test garbage inputs for mmap
+ * input: none
+ * output: none 
+ * side effect: should pass if mmap return -1
+ */
+int test_mmap_fail(){
+
+	int32_t i, j, k, l, fd;
+	uint8_t* buf;
+
+	// a regular file, so only the bad argument makes the call fail
+	fd = open((uint8_t*)"frame0.txt");
+	if (fd == -1) return FAIL;
+
+	i = mmap(0, 4096, &buf);							// stdin has no data blocks
+	j = mmap(fd, 4096, NULL);							// no place for the address
+	k = mmap(fd, 4096, (uint8_t**)(0x07000000));		// put invalide address
+	l = mmap(9, 4096, (uint8_t**)(0x08000000));		// fd out of range
+	close(fd);
+	// -1 for wrong input, 0 for success
+	if (i == -1 && j == -1 && k == -1 && l == -1){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_set_handler_fail
+ * description: 
+ * test garbage inputs for set_handler
+ * input: none
+ * output: none 
+ * side effect: should pass if set_handler return -1
+ */
+int test_set_handler_fail(){
+
+	int32_t i, j, k;
+
+	i = set_handler(-1, NULL);							// signal number too small
+	j = set_handler(NUM_SIGNALS, NULL);					// signal number too large
+	k = set_handler(ALARM, (void*)(0x07000000));		// handler outside user memory
+	// -1 for wrong input, 0 for success
+	if (i == -1 && j == -1 && k == -1){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_clock_monotonic
+ * description: 
+ * test that the TSC was calibrated and the clock never goes back
+ * input: none
+ * output: none 
+ * side effect: should pass if the clock keeps increasing
+ */
+int test_clock_monotonic(){
+
+	int32_t i;
+	uint64_t last, now;
+
+	if (clock_tsc_khz() <= 1) return FAIL;		// calibration failed
+	last = clock_ns();
+	for (i = 0; i < 1000; i++){
+		now = clock_ns();
+		if (now < last) return FAIL;
+		last = now;
+	}
+	return PASS;
+}
+
+/* 
+ * test_serial_write
+ * description: 
+ * open the serial port by name and queue a line on it
+ * input: none
+ * output: none 
+ * side effect: "serial test" shows up on COM1
+ */
+int test_serial_write(){
+
+	int32_t fd, ret;
+
+	fd = open((uint8_t*)"ttyS0");
+	if (fd == -1) return FAIL;
+	ret = write(fd, "serial test\n", 12);
+	close(fd);
+	if (ret == 12){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_profile
+ * description: 
+ * sample for a while, the ticks land in the histogram and a bad
+ * command is refused
+ * input: none
+ * output: none 
+ * side effect: the profile is dumped to COM1
+ */
+int test_profile(){
+
+	int32_t samples;
+	volatile uint32_t i;
+
+	if (profile(PROFILE_START) != 0) return FAIL;
+	for (i = 0; i < 100000000; i++);
+	profile(PROFILE_STOP);
+	samples = profile(PROFILE_DUMP);
+	if (samples > 0 && profile(-1) == -1){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_smp_online
+ * description: 
+ * every processor the MP table lists made it to ap_main
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+int test_smp_online(){
+	if (smp_cpu_count() >= 1 && smp_online_count() == smp_cpu_count()){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_spinlock
+ * description: 
+ * a lock taken twice with interrupts saved counts both holds, and lets go
+ * of preemption and the interrupt flag as it found them
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+int test_spinlock(){
+	static spinlock_t lock = SPINLOCK_INIT("test");
+	uint32_t flags, before, after;
+
+	cli_and_save(before);
+	restore_flags(before);
+	flags = spin_lock_irqsave(&lock);
+	if (!lock.locked || !preempt_disabled()){
+		spin_unlock_irqrestore(&lock, flags);
+		return FAIL;
+	}
+	spin_unlock_irqrestore(&lock, flags);
+	spin_lock(&lock);
+	spin_unlock(&lock);
+	cli_and_save(after);
+	restore_flags(after);
+
+	if (lock.acquired == 2 && lock.contended == 0 && !lock.locked &&
+		!preempt_disabled() && (before & EFLAGS_IF) == (after & EFLAGS_IF) && lock.total_hold >= lock.max_hold){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_irq_latency
+ * description: 
+ * the PIT is counted while time passes, every interrupt that was handled
+ * shows up in the handler histogram, and bad irq lines are refused
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+int test_irq_latency(){
+	irq_stat_t st;
+	uint32_t i, handled = 0;
+	uint64_t end = clock_ns() + 50 * NS_PER_MS;
+
+	while (clock_ns() < end);
+	if (irq_latency_read(IRQ_ZERO, &st) == -1) return FAIL;
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		handled += st.handler[i];
+
+	if (st.count > 0 && handled == st.count && st.tsc_khz == clock_tsc_khz() &&
+		irq_latency_read(LATENCY_IRQS, &st) == -1){
+		return PASS;
+	}
+	return FAIL;
+}
+
+static volatile uint32_t softirq_test_runs = 0;
+
+/* the bottom half of test_softirq */
+static void softirq_test_handler(){
+	softirq_test_runs++;
+}
+
+/* 
+ * test_softirq
+ * description: 
+ * a raised softirq runs once on an interrupt return to code with
+ * interrupts on, and not at all on one to code with them off
+ * input: none
+ * output: none 
+ * side effect: takes the last softirq number
+ */
+int test_softirq(){
+	hw_context_t regs;
+
+	softirq_register(SOFTIRQ_MAX - 1, softirq_test_handler);
+	softirq_test_runs = 0;
+
+	regs.eflags = 0;
+	softirq_raise(SOFTIRQ_MAX - 1);
+	do_softirq(&regs);
+	if (softirq_test_runs != 0) return FAIL;
+
+	regs.eflags = EFLAGS_IF;
+	do_softirq(&regs);
+	do_softirq(&regs);
+	softirq_register(SOFTIRQ_MAX - 1, NULL);
+
+	if (softirq_test_runs == 1 && !preempt_disabled()){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_poll_entries
+ * description: 
+ * the poll entries of the jump tables: a file is always ready, an rtc
+ * descriptor is readable once a tick it has not read came, and reading it
+ * then does not wait
+ * input: none
+ * output: none 
+ * side effect: opens and closes a file and the rtc
+ */
+int test_poll_entries(){
+	int32_t file_fd, rtc_fd, before, after, read_back;
+	uint32_t flags, tick;
+	uint8_t file_name[] = "frame0.txt";
+	uint8_t rtc_name[] = "rtc";
+	func_ptr *ops;
+
+	file_fd = open(file_name);
+	if (file_fd == -1) return FAIL;
+	ops = get_pcb()->descriptors[file_fd].file_operations_table_ptr;
+	if (ops[POLL_FUNC](file_fd) != (POLLIN | POLLOUT)){
+		close(file_fd);
+		return FAIL;
+	}
+	close(file_fd);
+
+	// no tick may come in between, one is made up instead
+	cli_and_save(flags);
+	rtc_fd = open(rtc_name);
+	if (rtc_fd == -1){
+		restore_flags(flags);
+		return FAIL;
+	}
+	ops = get_pcb()->descriptors[rtc_fd].file_operations_table_ptr;
+	before = ops[POLL_FUNC](rtc_fd);
+	rtc_ticks++;
+	after = ops[POLL_FUNC](rtc_fd);
+	read(rtc_fd, &tick, sizeof(tick));
+	read_back = ops[POLL_FUNC](rtc_fd);
+	close(rtc_fd);
+	restore_flags(flags);
+
+	if (before == POLLOUT && after == (POLLIN | POLLOUT) && read_back == POLLOUT){
+		return PASS;
+	}
+	return FAIL;
+}
+
+/* 
+ * test_fcntl_nonblock
+ * description: 
+ * a read of an O_NONBLOCK rtc descriptor fails with -EAGAIN until a tick
+ * came, and fcntl takes no flag it does not know
+ * input: none
+ * output: none 
+ * side effect: opens and closes the rtc
+ */
+int test_fcntl_nonblock(){
+	int32_t rtc_fd, result = PASS;
+	uint32_t flags, tick;
+	uint8_t rtc_name[] = "rtc";
+
+	// no tick may come in between, one is made up instead
+	cli_and_save(flags);
+	rtc_fd = open(rtc_name);
+	if (rtc_fd == -1){
+		restore_flags(flags);
+		return FAIL;
+	}
+	if (fcntl(rtc_fd, F_GETFL, 0) != 0) result = FAIL;
+	if (fcntl(rtc_fd, F_SETFL, ~0) != -1) result = FAIL;
+	if (fcntl(rtc_fd, F_SETFL, O_NONBLOCK) != 0) result = FAIL;
+	if (fcntl(rtc_fd, F_GETFL, 0) != O_NONBLOCK) result = FAIL;
+	if (read(rtc_fd, &tick, sizeof(tick)) != -EAGAIN) result = FAIL;
+	rtc_ticks++;
+	if (read(rtc_fd, &tick, sizeof(tick)) != 0) result = FAIL;
+	if (read(rtc_fd, &tick, sizeof(tick)) != -EAGAIN) result = FAIL;
+	close(rtc_fd);
+	restore_flags(flags);
+
+	return result;
+}
+
+/* 
+ * test_account
+ * description: 
+ * the accounting hooks count on the running pcb, and procstat takes no
+ * buffer outside of user space
+ * input: none
+ * output: none 
+ * side effect: the counters of the running pcb are cleared
+ */
+int test_account(){
+	uint32_t flags;
+	proc_account_t *acct = &get_pcb()->acct;
+	proc_stat_t stat;
+	int result = PASS;
+
+	cli_and_save(flags);
+	memset(acct, 0, sizeof(proc_account_t));
+	account_tick();
+	account_syscall();
+	account_syscall();
+	account_page_fault();
+	if (acct->ticks != 1 || acct->syscalls != 2 || acct->page_faults != 1 || acct->switches != 0)
+		result = FAIL;
+	memset(acct, 0, sizeof(proc_account_t));
+	restore_flags(flags);
+
+	if (procstat(NULL, 1) != -1) result = FAIL;
+	if (procstat(&stat, 1) != -1) result = FAIL;
+	if (procstat(&stat, 0) != 0) result = FAIL;
+	return result;
+}
+
+static volatile uint32_t test_work_runs = 0;
+
+/* 
+ * test_work_func
+ * description: 
+ * the work test_workqueue queues, counts its runs
+ * input: work -- not used
+ * output: none 
+ * side effect: none
+ */
+static void test_work_func(work_t *work){
+	test_work_runs++;
+}
+
+/* 
+ * test_workqueue
+ * description: 
+ * work queues once until a worker takes it, the workers only run once
+ * the shells are up so it is still pending here
+ * input: none
+ * output: none 
+ * side effect: leaves the work queued, a worker runs it later
+ */
+int test_workqueue(){
+	static work_t work = WORK_INIT(test_work_func);
+	int result = PASS;
+
+	if (queue_work(NULL) != -1) result = FAIL;
+	if (queue_work(&work) != 0) result = FAIL;
+	if (queue_work(&work) != -1) result = FAIL;
+	if (!work.pending || test_work_runs != 0) result = FAIL;
+	if (kthread_current() != KTHREAD_NONE) result = FAIL;
+	return result;
+}
+
+/* 
+ * test_prezero
+ * description: 
+ * a frame execute claims before the zeroer got to it is cleared on
+ * demand, the last pid is not running this early
+ * input: none
+ * output: none 
+ * side effect: hands the frame back to the zeroer at the end
+ */
+int test_prezero(){
+	uint32_t pid = MAX_PROCESS_NUM - 1;
+	uint8_t *frame = (uint8_t *)(PROGRAM_FRAME_ADDR + pid * PROGRAM_FRAME_SIZE);
+	int result = PASS;
+
+	if (process[pid] != PROCESS_OFF) return FAIL;
+	frame[0] = 0xAA;
+	frame[PROGRAM_FRAME_SIZE - 1] = 0xAA;
+	prezero_release(pid);
+	prezero_claim(pid);
+	if (frame[0] != 0 || frame[PROGRAM_FRAME_SIZE - 1] != 0) result = FAIL;
+	prezero_release(pid);
+	return result;
+}
+
+/* 
+ * test_futex
+ * description: 
+ * futex_wait must not sleep on a word that changed, a wake with no
+ * sleeper wakes nothing, and no terminal has a thread to switch to
+ * before clone is called
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+int test_futex(){
+	uint32_t word = 1;
+	int result = PASS;
+
+	if (futex_sleep(&word, 0) != -EAGAIN) result = FAIL;
+	if (futex_wakeup(&word, FUTEX_WAKE_ALL) != 0) result = FAIL;
+	if (thread_runnable(TERM_ZERO) != NO) result = FAIL;
+	return result;
+}
+
+/* 
+ * test_ring
+ * description: 
+ * a second ring_setup hands back the same rings, and one ring_enter runs
+ * a nop, a read into an unmapped page, a write running from the program
+ * page into the stack and an unknown opcode, in order. Only the nop may
+ * succeed
+ * input: none
+ * output: none 
+ * side effect: maps the rings into the current process
+ */
+int test_ring(){
+	int32_t addr;
+	uint32_t sq, cq, i;
+	io_ring_t *ring;
+	ring_sqe_t *sqe;
+	int result = PASS;
+
+	if ((addr = ring_setup()) == -1) return FAIL;
+	if (ring_setup() != addr) return FAIL;
+	ring = (io_ring_t *)addr;
+	sq = ring->sq_tail;
+	cq = ring->cq_tail;
+
+	for (i = 0; i < 4; i++) {
+		sqe = &ring->sq[(sq + i) & RING_MASK];
+		sqe->opcode = RING_OP_NOP;
+		sqe->fd = 1;
+		sqe->buf = (void *)_128MB;
+		sqe->len = 16;
+		sqe->user_data = i;
+	}
+	ring->sq[(sq + 1) & RING_MASK].opcode = RING_OP_READ;
+	ring->sq[(sq + 1) & RING_MASK].buf = (void *)0x07000000;		// put invalide address
+	ring->sq[(sq + 2) & RING_MASK].opcode = RING_OP_WRITE;
+	ring->sq[(sq + 2) & RING_MASK].len = USER_STACK_TOP - _128MB - 1;	// both ends mapped, the middle not
+	ring->sq[(sq + 3) & RING_MASK].opcode = 7;						// no such operation
+	ring->sq_tail = sq + 4;
+
+	if (ring_enter(0) != 0) result = FAIL;
+	if (ring_enter(4) != 4) result = FAIL;
+	if (ring->sq_head != sq + 4 || ring->cq_tail != cq + 4) result = FAIL;
+	for (i = 0; i < 4; i++) {
+		if (ring->cq[(cq + i) & RING_MASK].user_data != i) result = FAIL;
+		if (ring->cq[(cq + i) & RING_MASK].result != (i == 0 ? 0 : -1)) result = FAIL;
+	}
+	ring->cq_head = cq + 4;
+	return result;
+}
+
+/* 
+ * test_vdso
+ * description: 
+ * the vdso page of the current process shows its program, its terminal
+ * and the terminal on the screen, and its ticks are in VDSO_TICK_HZ
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+int test_vdso(){
+	vdso_t *vdso = (vdso_t *)USER_VDSO_ADDR;
+	pcb_t *mm_pcb = get_mm_pcb();
+	int result = PASS;
+
+	if (vdso->pid != mm_pcb->pid) result = FAIL;
+	if (vdso->terminal_id != mm_pcb->terminal_id) result = FAIL;
+	if (vdso->looking_terminal != get_current_looking_terminal()) result = FAIL;
+	if (vdso->tick_hz != VDSO_TICK_HZ) result = FAIL;
+	return result;
+}
+
 // /* Checkpoint 5 tests */	
 
 // // launch the test
@@ -696,4 +1198,334 @@ void launch_tests(){
 	// check point 4
 	//TEST_OUTPUT("test system call getarges",test_getargs_fail());
 	//TEST_OUTPUT("test system call vidmap",test_vidmap_fail());
+	//TEST_OUTPUT("test system call mmap",test_mmap_fail());
+	//TEST_OUTPUT("test system call set_handler",test_set_handler_fail());
+	//TEST_OUTPUT("test clock monotonic",test_clock_monotonic());
+	//TEST_OUTPUT("test serial write",test_serial_write());
+	//TEST_OUTPUT("test profile",test_profile());
+	//TEST_OUTPUT("test smp online",test_smp_online());
+	//TEST_OUTPUT("test spinlock",test_spinlock());
+	//TEST_OUTPUT("test irq latency",test_irq_latency());
+	//TEST_OUTPUT("test softirq",test_softirq());
+	//TEST_OUTPUT("test poll entries",test_poll_entries());
+	//TEST_OUTPUT("test fcntl nonblock",test_fcntl_nonblock());
+	//TEST_OUTPUT("test account",test_account());
+	//TEST_OUTPUT("test workqueue",test_workqueue());
+	//TEST_OUTPUT("test prezero",test_prezero());
+	//TEST_OUTPUT("test futex",test_futex());
+	//TEST_OUTPUT("test ring",test_ring());
+	//TEST_OUTPUT("test vdso",test_vdso());
  }
+
+#ifdef RUN_BENCHMARKS
+
+/* Benchmarks, built with make RUN_BENCHMARKS=1 */
+
+// iterations of every benchmark, odd so the median is one sample
+#define BENCH_RUNS              65
+#define BENCH_BUFFER_SIZE       0x10000
+#define BENCH_COPY_SIZE         4096
+#define BENCH_FILE              "hello"
+#define BENCH_BIG_FILE          "fish"
+#define BENCH_TEXT_FILE         "verylargetextwithverylongname.txt"
+#define BENCH_SYSCALL           13  /* clock_gettime */
+
+static uint32_t bench_samples[BENCH_RUNS];
+static uint8_t bench_buffer[BENCH_BUFFER_SIZE];
+static uint8_t bench_copy[BENCH_COPY_SIZE];
+static uint32_t bench_cat_read[BENCH_RUNS];
+static uint32_t bench_cat_send[BENCH_RUNS];
+
+/* 
+ * bench_report
+ * description: 
+ * sort the samples of a benchmark and print min/median/max in TSC cycles
+ * input: name -- what was timed
+ * output: one line on the screen and COM1
+ * side effect: bench_samples is sorted
+ */
+static void bench_report(int8_t *name){
+	int32_t i, j;
+	uint32_t sample;
+
+	for (i = 1; i < BENCH_RUNS; i++){
+		sample = bench_samples[i];
+		for (j = i - 1; j >= 0 && bench_samples[j] > sample; j--)
+			bench_samples[j + 1] = bench_samples[j];
+		bench_samples[j + 1] = sample;
+	}
+	printf("[BENCH %s] min = %u median = %u max = %u cycles\n", name,
+		bench_samples[0], bench_samples[BENCH_RUNS / 2], bench_samples[BENCH_RUNS - 1]);
+}
+
+/* 
+ * bench_read_dentry_by_name
+ * description: 
+ * time a directory lookup
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+static void bench_read_dentry_by_name(){
+	int32_t i;
+	uint64_t start;
+	dentry_t dentry;
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		read_dentry_by_name((uint8_t*)BENCH_FILE, &dentry);
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	bench_report("read_dentry_by_name");
+}
+
+/* 
+ * bench_read_data
+ * description: 
+ * time reading the largest program in one call
+ * input: none
+ * output: none 
+ * side effect: bench_buffer is overwritten
+ */
+static void bench_read_data(){
+	int32_t i;
+	uint64_t start;
+	dentry_t dentry;
+
+	if (read_dentry_by_name((uint8_t*)BENCH_BIG_FILE, &dentry) == -1) return;
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		read_data(dentry.inodes, 0, bench_buffer, BENCH_BUFFER_SIZE);
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	bench_report("read_data " BENCH_BIG_FILE);
+}
+
+/* 
+ * bench_memcpy
+ * description: 
+ * time copying a page
+ * input: none
+ * output: none 
+ * side effect: bench_copy is overwritten
+ */
+static void bench_memcpy(){
+	int32_t i;
+	uint64_t start;
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		memcpy(bench_copy, bench_buffer, BENCH_COPY_SIZE);
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	bench_report("memcpy 4KB");
+}
+
+/* 
+ * bench_scroll
+ * description: 
+ * time scrolling the screen by a line, run first since it scrolls
+ * everything away
+ * input: none
+ * output: none 
+ * side effect: the screen is cleared at the end
+ */
+static void bench_scroll(){
+	int32_t i;
+	uint64_t start;
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		scroll();
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	clear();
+	set_x(0);
+	set_y(0);
+	bench_report("scroll");
+}
+
+/* 
+ * bench_cat
+ * description: 
+ * time printing the large text file the way cat did, read_data into a
+ * buffer and terminal_write from it, against send_data handing the
+ * blocks of the image to terminal_write. Run before bench_scroll since
+ * it fills the screen, bench_cat_report prints the results
+ * input: none
+ * output: none 
+ * side effect: bench_buffer is overwritten, the screen is cleared at the end
+ */
+static void bench_cat(){
+	int32_t i, length;
+	uint64_t start;
+	dentry_t dentry;
+
+	read_dentry_by_name((uint8_t*)BENCH_TEXT_FILE, &dentry);
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		length = read_data(dentry.inodes, 0, bench_buffer, BENCH_BUFFER_SIZE);
+		terminal_write(1, bench_buffer, length);
+		bench_cat_read[i] = (uint32_t)(rdtsc() - start);
+
+		start = rdtsc();
+		send_data(dentry.inodes, 0, BENCH_BUFFER_SIZE, terminal_write, 1);
+		bench_cat_send[i] = (uint32_t)(rdtsc() - start);
+	}
+	clear();
+	set_x(0);
+	set_y(0);
+}
+
+/* 
+ * bench_cat_report
+ * description: 
+ * print what bench_cat measured
+ * input: none
+ * output: none 
+ * side effect: bench_samples is overwritten
+ */
+static void bench_cat_report(){
+	memcpy(bench_samples, bench_cat_read, sizeof(bench_samples));
+	bench_report("read_data+write " BENCH_TEXT_FILE);
+	memcpy(bench_samples, bench_cat_send, sizeof(bench_samples));
+	bench_report("send_data " BENCH_TEXT_FILE);
+}
+
+/* 
+ * bench_zero_frame
+ * description: 
+ * time clearing a program frame, what execute pays when the zeroer has
+ * not been to the frame yet. The last pid is not running this early
+ * input: none
+ * output: none 
+ * side effect: the frame is cleared
+ */
+static void bench_zero_frame(){
+	int32_t i;
+	uint64_t start;
+	uint8_t *frame = (uint8_t *)(PROGRAM_FRAME_ADDR + (MAX_PROCESS_NUM - 1) * PROGRAM_FRAME_SIZE);
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		memset(frame, 0, PROGRAM_FRAME_SIZE);
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	bench_report("zero program frame");
+}
+
+/* 
+ * bench_putc
+ * description: 
+ * time printing one character, always at the cursor so the report
+ * overwrites it
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+static void bench_putc(){
+	int32_t i, x, y;
+	uint64_t start;
+
+	x = get_x();
+	y = get_y();
+	for (i = 0; i < BENCH_RUNS; i++){
+		set_x(x);
+		set_y(y);
+		start = rdtsc();
+		putc('a');
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	set_x(x);
+	set_y(y);
+	bench_report("putc");
+}
+
+/* 
+ * bench_switch_screen
+ * description: 
+ * time switching the screen to the second terminal, switching back is
+ * not timed
+ * input: none
+ * output: none 
+ * side effect: the first terminal is on the screen at the end
+ */
+static void bench_switch_screen(){
+	int32_t i;
+	uint64_t start;
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		switch_screen(TERM_ONE);
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+		switch_screen(TERM_ZERO);
+	}
+	bench_report("switch_screen");
+}
+
+/* 
+ * bench_syscall
+ * description: 
+ * time a system call that fails its argument check at once, so the
+ * sample is the trap, the linker and the return
+ * input: none
+ * output: none 
+ * side effect: none
+ */
+static void bench_syscall(){
+	int32_t i, ret;
+	uint64_t start;
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		asm volatile("int $0x80" : "=a"(ret) : "a"(BENCH_SYSCALL), "b"(0) : "memory", "cc");
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	bench_report("syscall round trip");
+}
+
+/* 
+ * bench_execute_load
+ * description: 
+ * time the part of execute that finds and loads hello, a whole execute
+ * can not run here since halting the first process starts a shell
+ * input: none
+ * output: none 
+ * side effect: bench_buffer is overwritten
+ */
+static void bench_execute_load(){
+	int32_t i;
+	uint64_t start;
+	dentry_t dentry;
+
+	for (i = 0; i < BENCH_RUNS; i++){
+		start = rdtsc();
+		read_dentry_by_name((uint8_t*)BENCH_FILE, &dentry);
+		read_data(dentry.inodes, 0, bench_buffer, BENCH_BUFFER_SIZE);
+		bench_samples[i] = (uint32_t)(rdtsc() - start);
+	}
+	bench_report("execute load " BENCH_FILE);
+}
+
+// launch the benchmarks
+void launch_benchmarks(){
+	uint32_t flags;
+
+	// the first PIT tick starts the shells, keep it out until the end
+	cli_and_save(flags);
+	bench_cat();
+	bench_scroll();
+	printf("[BENCH] tsc_khz = %u runs = %u\n", clock_tsc_khz(), BENCH_RUNS);
+	bench_putc();
+	bench_cat_report();
+	bench_read_dentry_by_name();
+	bench_read_data();
+	bench_memcpy();
+	bench_switch_screen();
+	bench_syscall();
+	bench_execute_load();
+	bench_zero_frame();
+	restore_flags(flags);
+}
+
+#endif /* RUN_BENCHMARKS */
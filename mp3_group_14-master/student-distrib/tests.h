@@ -7,6 +7,10 @@
 #include "keyboard.h"
 #include "file_system.h"
 #include "rtc_handler.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "latency.h"
+#include "softirq.h"
 
 
 
@@ -15,5 +19,8 @@
 // test launcher
 void launch_tests();
 
+// benchmark launcher, built with make RUN_BENCHMARKS=1
+void launch_benchmarks();
+
 
 #endif /* TESTS_H */
@@ -0,0 +1,378 @@
+#include "thread.h"
+#include "lib.h"
+#include "do_sys.h"
+#include "schedule.h"
+#include "signal.h"
+#include "clock.h"
+
+/*
+ * thread_group_next
+ *   DESCRIPTION: find the task of the same program that is to have the
+ *                terminal after pid, round robin in pid order. The tasks of
+ *                a program all run on the terminal it was started on
+ *   INPUTS: uint32_t pid -- the task the terminal runs now
+ *           int32_t waiting -- whether a task waiting in idle_wait counts
+ *   OUTPUTS: none
+ *   RETURN VALUE: the pid, -1 if there is no such other task
+ *   SIDE EFFECTS: none
+ */
+static int32_t thread_group_next(uint32_t pid, int32_t waiting)
+{
+  uint32_t i, next;
+  pcb_t *other, *pcb = get_pcb_by_pid(pid);
+
+  for (i = 1; i < MAX_PROCESS_NUM; i++)
+  {
+    next = (pid + i) % MAX_PROCESS_NUM;
+    if (process[next] == PROCESS_OFF) continue;
+    other = get_pcb_by_pid(next);
+    if (other->tgid != pcb->tgid || other->thread_dead) continue;
+    if (other->sched_waiting == YES && !waiting) continue;
+    return next;
+  }
+  return -1;
+}
+
+/*
+ * thread_close_files
+ *   DESCRIPTION: close what a task has open, as halt_process does
+ *   INPUTS: pcb_t *pcb -- the task
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+static void thread_close_files(pcb_t *pcb)
+{
+  int32_t i;
+
+  for (i = 0; i < MAX_FILE; i++)
+  {
+    if (pcb->descriptors[i].f_flag == INUSE)
+    {
+      pcb->descriptors[i].file_operations_table_ptr[3](0);
+      pcb->descriptors[i].f_flag = UNUSE;
+    }
+  }
+}
+
+/*
+ * thread_reap
+ *   DESCRIPTION: free the pids of the halted threads of a program the
+ *                scheduler already switched away from. thread_rotate frees
+ *                a pid when it switches away, this catches one it left,
+ *                so a join that saw the tid cleared can always clone again
+ *   INPUTS: uint32_t tgid -- the pid of the program
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: called with preemption off, so no switch runs meanwhile
+ */
+static void thread_reap(uint32_t tgid)
+{
+  uint32_t pid;
+  pcb_t *pcb;
+
+  for (pid = 0; pid < MAX_PROCESS_NUM; pid++)
+  {
+    if (process[pid] == PROCESS_OFF) continue;
+    pcb = get_pcb_by_pid(pid);
+    if (pcb->tgid != tgid || !pcb->thread_dead) continue;
+    // still on its kernel stack until its terminal switches away
+    if (terminals[pcb->terminal_id].current_pid == pid) continue;
+    pcb->thread_dead = 0;
+    put_pid(pid);
+  }
+}
+
+/*
+ * thread_runnable
+ *   DESCRIPTION: whether a terminal has a thread to switch to other than
+ *                the task it runs now, so the terminal is not waiting even
+ *                if that task sleeps in idle_wait
+ *   INPUTS: uint32_t t_id -- the terminal
+ *   OUTPUTS: none
+ *   RETURN VALUE: YES or NO
+ *   SIDE EFFECTS: none
+ */
+int32_t thread_runnable(uint32_t t_id)
+{
+  return thread_group_next(terminals[t_id].current_pid, NO) != -1 ? YES : NO;
+}
+
+/*
+ * thread_rotate
+ *   DESCRIPTION: called by pit_handler before it switches to a terminal.
+ *                The threads of a program take turns at the slot of its
+ *                terminal: the context saved for the terminal goes into the
+ *                pcb of its task, and the next runnable thread's takes its
+ *                place. A thread that halted is only ever switched away
+ *                from, and its pid is freed here as nothing runs on its
+ *                kernel stack any more
+ *   INPUTS: uint32_t t_id -- the terminal about to run
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if another task got the terminal, 0 otherwise
+ *   SIDE EFFECTS: changes the current_pid of the terminal
+ */
+int32_t thread_rotate(uint32_t t_id)
+{
+  int32_t next;
+  pcb_t *in, *out = get_pcb_by_pid(terminals[t_id].current_pid);
+
+  next = thread_group_next(out->pid, NO);
+  // a halted thread hands over even to one that waits
+  if (next == -1 && out->thread_dead)
+    next = thread_group_next(out->pid, YES);
+  if (next == -1) return 0;
+
+  out->sched_esp = terminals[t_id].saved_esp;
+  out->sched_ebp = terminals[t_id].saved_ebp;
+  out->sched_esp0 = terminals[t_id].esp0;
+  out->sched_waiting = terminals[t_id].waiting;
+  if (out->thread_dead)
+  {
+    out->thread_dead = 0;
+    put_pid(out->pid);
+  }
+
+  in = get_pcb_by_pid(next);
+  terminals[t_id].saved_esp = in->sched_esp;
+  terminals[t_id].saved_ebp = in->sched_ebp;
+  terminals[t_id].esp0 = in->sched_esp0;
+  terminals[t_id].waiting = in->sched_waiting;
+  terminals[t_id].current_pid = next;
+  return 1;
+}
+
+/*
+ * thread_take_frame
+ *   DESCRIPTION: a thread that never ran has no switch to return from, it
+ *                leaves the kernel through interrupt_return with the frame
+ *                clone built on its kernel stack
+ *   INPUTS: uint32_t pid -- the task about to run
+ *   OUTPUTS: none
+ *   RETURN VALUE: the frame, NULL if the task ran before
+ *   SIDE EFFECTS: the frame is handed out once
+ */
+void *thread_take_frame(uint32_t pid)
+{
+  pcb_t *pcb = get_pcb_by_pid(pid);
+  void *frame = pcb->thread_frame;
+
+  pcb->thread_frame = NULL;
+  return frame;
+}
+
+/*
+ * thread_wake_terminal
+ *   DESCRIPTION: called by wake_terminal, an event for a terminal may be the
+ *                one a thread that is not on it waits for, so those threads
+ *                get to check again
+ *   INPUTS: uint32_t t_id -- the terminal
+ *   OUTPUTS: none
+ *   RETURN VALUE: the threads woken
+ *   SIDE EFFECTS: none
+ */
+int32_t thread_wake_terminal(uint32_t t_id)
+{
+  uint32_t pid;
+  int32_t woken = 0;
+  pcb_t *pcb, *running = get_pcb_by_pid(terminals[t_id].current_pid);
+
+  for (pid = 0; pid < MAX_PROCESS_NUM; pid++)
+  {
+    if (process[pid] == PROCESS_OFF || pid == running->pid) continue;
+    pcb = get_pcb_by_pid(pid);
+    if (pcb->tgid != running->tgid || pcb->sched_waiting == NO) continue;
+    pcb->sched_waiting = NO;
+    woken++;
+  }
+  return woken;
+}
+
+/*
+ * thread_create
+ *   DESCRIPTION: start a thread of the current program. It gets a pid, a
+ *                pcb and a kernel stack of its own but shares the page
+ *                directory, so the heap, the mmap region and the vidmap page
+ *                of the program. It enters user space at entry on the stack
+ *                given, with the registers of the caller, and first runs
+ *                when the scheduler rotates to it
+ *   INPUTS: void *entry -- where the thread starts
+ *           void *stack -- the top of its user stack
+ *           uint32_t *tid_addr -- gets the pid now, and 0 with a futex
+ *                                 wakeup when the thread halts
+ *   OUTPUTS: none
+ *   RETURN VALUE: the pid of the thread, -1 when no pid is left
+ *   SIDE EFFECTS: none
+ */
+int32_t thread_create(void *entry, void *stack, uint32_t *tid_addr)
+{
+  int32_t i, pid;
+  pcb_t *pcb, *current_pcb = get_pcb();
+  hw_context_t *regs, *frame;
+
+  // the pcb is not whole until the end, keep the scheduler off it
+  preempt_disable();
+  thread_reap(current_pcb->tgid);
+  if ((pid = get_next_pid()) == -1)
+  {
+    preempt_enable();
+    return -1;
+  }
+
+  pcb = get_pcb_by_pid(pid);
+  pcb_init(pcb, pid);
+  strncpy(pcb->name, current_pcb->name, PROCESS_NAME_LEN);
+  pcb->name[PROCESS_NAME_LEN] = '\0';
+  pcb->page_directory = current_pcb->page_directory;
+  pcb->tgid = current_pcb->tgid;
+  pcb->clear_tid = (uint32_t)tid_addr;
+  for (i = 0; i < NUM_SIGNALS; i++)
+    pcb->sig_handlers[i] = current_pcb->sig_handlers[i];
+
+  // the frame of this system call sits at the top of the kernel stack
+  regs = (hw_context_t *)(tss.esp0 - sizeof(hw_context_t));
+  frame = (hw_context_t *)(PCB_BASE + (MAX_PCB - pid) * _8KB + _8KB - PCB_OFFSET) - 1;
+  memcpy(frame, regs, sizeof(hw_context_t));
+  frame->eax = 0;
+  frame->return_address = (uint32_t)entry;
+  frame->esp = (uint32_t)stack;
+  pcb->thread_frame = frame;
+  pcb->sched_esp0 = (uint32_t)(frame + 1);
+  pcb->sched_waiting = NO;
+
+  if (tid_addr != NULL) *tid_addr = pid;
+  preempt_enable();
+  return pid;
+}
+
+/*
+ * thread_exit
+ *   DESCRIPTION: halt for a thread made by clone. The program goes on, so
+ *                nothing of its address space goes away. The thread sleeps
+ *                until thread_rotate switches away from it for good
+ *   INPUTS: uint32_t status -- HALT_BY_SIGNAL takes the program down too
+ *   OUTPUTS: none
+ *   RETURN VALUE: none, never returns
+ *   SIDE EFFECTS: clears and wakes the tid word given to clone
+ */
+void thread_exit(uint32_t status)
+{
+  pcb_t *pcb = get_pcb();
+  uint32_t *tid = (uint32_t *)pcb->clear_tid;
+
+  preempt_disable();
+  thread_close_files(pcb);
+  timer_cancel(pcb->pid);
+
+  // the user stack of the thread is not touched after this, it can be freed
+  if (tid != NULL && user_ptr_valid(tid))
+  {
+    *tid = 0;
+    futex_wakeup(tid, FUTEX_WAKE_ALL);
+  }
+
+  // a thread that faulted or was interrupted ends its program
+  if (status == HALT_BY_SIGNAL)
+    send_signal(pcb->tgid, INTERRUPT);
+
+  cli();
+  pcb->thread_dead = 1;
+  preempt_enable();
+  while (1) idle_wait();
+}
+
+/*
+ * thread_group_kill
+ *   DESCRIPTION: called by halt_process of a program, its threads go with
+ *                its address space. They wait for a turn at the terminal
+ *                the program runs on, so their kernel stacks are just left
+ *   INPUTS: uint32_t tgid -- the pid of the program
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: frees their pids
+ */
+void thread_group_kill(uint32_t tgid)
+{
+  uint32_t pid;
+  pcb_t *pcb;
+
+  for (pid = 0; pid < MAX_PROCESS_NUM; pid++)
+  {
+    if (pid == tgid || process[pid] == PROCESS_OFF) continue;
+    pcb = get_pcb_by_pid(pid);
+    if (pcb->tgid != tgid) continue;
+    thread_close_files(pcb);
+    timer_cancel(pid);
+    pcb->thread_dead = 0;
+    put_pid(pid);
+  }
+}
+
+/*
+ * futex_sleep
+ *   DESCRIPTION: sleep until futex_wakeup on a word, if it still holds the
+ *                value the caller saw. Interrupts are off from the check to
+ *                the sleep, so a wakeup in between is not lost
+ *   INPUTS: uint32_t *addr -- the word, a checked user address
+ *           uint32_t val -- what the caller saw in it
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 when woken, -EAGAIN if the word changed, -1 for a
+ *                 signal that kills the process
+ *   SIDE EFFECTS: none
+ */
+int32_t futex_sleep(uint32_t *addr, uint32_t val)
+{
+  uint32_t flags;
+  int32_t ret = 0;
+  pcb_t *current_pcb = get_pcb();
+
+  cli_and_save(flags);
+  if (*(volatile uint32_t *)addr != val)
+  {
+    restore_flags(flags);
+    return -EAGAIN;
+  }
+
+  current_pcb->futex_addr = (uint32_t)addr;
+  while (current_pcb->futex_addr != 0 && !signal_kill_pending())
+    idle_wait();
+  if (current_pcb->futex_addr != 0)
+  {
+    current_pcb->futex_addr = 0;
+    ret = -1;
+  }
+  restore_flags(flags);
+  return ret;
+}
+
+/*
+ * futex_wakeup
+ *   DESCRIPTION: wake tasks of the current program sleeping on a word
+ *   INPUTS: uint32_t *addr -- the word
+ *           uint32_t count -- the most tasks to wake
+ *   OUTPUTS: none
+ *   RETURN VALUE: the tasks woken
+ *   SIDE EFFECTS: none
+ */
+int32_t futex_wakeup(uint32_t *addr, uint32_t count)
+{
+  uint32_t flags, pid;
+  uint32_t woken = 0;
+  pcb_t *pcb, *current_pcb = get_pcb();
+
+  cli_and_save(flags);
+  for (pid = 0; pid < MAX_PROCESS_NUM && woken < count; pid++)
+  {
+    if (process[pid] == PROCESS_OFF) continue;
+    pcb = get_pcb_by_pid(pid);
+    if (pcb->tgid != current_pcb->tgid || pcb->futex_addr != (uint32_t)addr) continue;
+    pcb->futex_addr = 0;
+    pcb->sched_waiting = NO;
+    // one that has its terminal is woken the usual way
+    if (terminals[pcb->terminal_id].current_pid == pid)
+      wake_terminal(pcb->terminal_id);
+    woken++;
+  }
+  restore_flags(flags);
+  return woken;
+}
@@ -0,0 +1,27 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "types.h"
+
+// the count of futex_wakeup that wakes every waiter
+#define FUTEX_WAKE_ALL      0xFFFFFFFF
+
+int32_t thread_runnable(uint32_t t_id);
+
+int32_t thread_rotate(uint32_t t_id);
+
+void *thread_take_frame(uint32_t pid);
+
+int32_t thread_wake_terminal(uint32_t t_id);
+
+int32_t thread_create(void *entry, void *stack, uint32_t *tid_addr);
+
+void thread_exit(uint32_t status);
+
+void thread_group_kill(uint32_t tgid);
+
+int32_t futex_sleep(uint32_t *addr, uint32_t val);
+
+int32_t futex_wakeup(uint32_t *addr, uint32_t count);
+
+#endif
@@ -0,0 +1,98 @@
+#include "trace.h"
+#include "clock.h"
+#include "serial.h"
+
+// the ring, trace_head counts every event ever recorded
+static trace_entry_t trace_buffer[TRACE_SIZE];
+static volatile uint32_t trace_head = 0;
+static volatile uint32_t trace_enabled = 1;
+
+/*
+ * trace_event
+ *   DESCRIPTION: record an event in the ring. A slot is claimed with one
+ *                atomic add, so an interrupt that records in the middle
+ *                takes the next slot instead of tearing this one
+ *   INPUTS: uint32_t type -- one of the TRACE_ event types
+ *           uint32_t arg -- what the event is about
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the oldest event is overwritten once the ring is full
+ */
+void trace_event(uint32_t type, uint32_t arg)
+{
+  uint32_t slot = 1;
+  trace_entry_t *entry;
+
+  if (!trace_enabled) return;
+
+  asm volatile("lock xaddl %0, %1" : "+r"(slot), "+m"(trace_head) : : "memory", "cc");
+  entry = &trace_buffer[slot & (TRACE_SIZE - 1)];
+  entry->tsc = rdtsc();
+  entry->type = type;
+  entry->arg = arg;
+}
+
+/*
+ * trace_hex
+ *   DESCRIPTION: write a number as 8 hex digits, zero padded
+ *   INPUTS: int8_t *buf -- where to write
+ *           uint32_t value -- the number
+ *   OUTPUTS: none
+ *   RETURN VALUE: the end of what was written
+ *   SIDE EFFECTS: none
+ */
+static int8_t *trace_hex(int8_t *buf, uint32_t value)
+{
+  int32_t i;
+  for (i = TRACE_HEX_DIGITS - 1; i >= 0; i--)
+  {
+    buf[i] = "0123456789abcdef"[value & 0xF];
+    value >>= 4;
+  }
+  return buf + TRACE_HEX_DIGITS;
+}
+
+/*
+ * trace_dump
+ *   DESCRIPTION: send the ring over COM1, oldest event first, one
+ *                "tsc type arg" line of hex per event after a header
+ *                giving the TSC rate. Recording stops while it runs
+ *   INPUTS: none
+ *   OUTPUTS: the trace on the serial port
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: busy-waits on the UART, takes seconds for a full ring
+ */
+void trace_dump()
+{
+  uint32_t i, start, end;
+  int8_t line[TRACE_LINE_SIZE];
+  int8_t *p;
+  trace_entry_t *entry;
+
+  trace_enabled = 0;
+  end = trace_head;
+  start = (end > TRACE_SIZE) ? end - TRACE_SIZE : 0;
+
+  serial_puts_polled("# trace tsc_khz=");
+  serial_puts_polled(itoa(clock_tsc_khz(), line, 10));
+  serial_puts_polled(" events=");
+  serial_puts_polled(itoa(end - start, line, 10));
+  serial_puts_polled("\n");
+
+  for (i = start; i != end; i++)
+  {
+    entry = &trace_buffer[i & (TRACE_SIZE - 1)];
+    p = trace_hex(line, (uint32_t)(entry->tsc >> 32));
+    p = trace_hex(p, (uint32_t)entry->tsc);
+    *p++ = ' ';
+    p = trace_hex(p, entry->type);
+    *p++ = ' ';
+    p = trace_hex(p, entry->arg);
+    *p++ = '\n';
+    *p = '\0';
+    serial_puts_polled(line);
+  }
+  serial_puts_polled("# end\n");
+
+  trace_enabled = 1;
+}
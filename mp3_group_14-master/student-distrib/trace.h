@@ -0,0 +1,34 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "types.h"
+
+// event types, also pushed by the linkers
+#define TRACE_SYSCALL       1   /* arg: system call number */
+#define TRACE_SYSCALL_RET   2   /* arg: return value */
+#define TRACE_IRQ           3   /* arg: irq number */
+#define TRACE_IRQ_RET       4   /* arg: irq number */
+#define TRACE_SWITCH        5   /* arg: old pid << 16 | new pid */
+
+// number of events kept, a power of two so the index wraps with a mask
+#define TRACE_SIZE          4096
+
+#ifndef ASM
+
+#define TRACE_HEX_DIGITS    8
+#define TRACE_LINE_SIZE     48
+
+/* one TSC stamped event */
+typedef struct trace_entry {
+  uint64_t tsc;
+  uint32_t type;
+  uint32_t arg;
+} trace_entry_t;
+
+void trace_event(uint32_t type, uint32_t arg);
+
+void trace_dump();
+
+#endif /* ASM */
+
+#endif
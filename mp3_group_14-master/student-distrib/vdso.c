@@ -0,0 +1,84 @@
+#include "vdso.h"
+#include "paging.h"
+#include "clock.h"
+
+/* one page per program, so pid and terminal_id can differ. The threads
+ * of a program share its page directory and so its page, a thread reads
+ * the pid of its program there and its own id in the tid clone wrote */
+typedef union vdso_page {
+  vdso_t data;
+  uint8_t page[_4KB];
+} vdso_page_t;
+
+static vdso_page_t vdso_pages[MAX_PROCESS_NUM] __attribute__((aligned (PTE_ALIGN_SIZE)));
+
+// what every page shows, kept here for the pages mapped later
+static volatile uint32_t vdso_ticks = 0;
+static volatile uint32_t vdso_looking = 0;
+
+/*
+ * vdso_map
+ *   DESCRIPTION: fill the vdso page of a new process and map it read-only
+ *                into its address space
+ *   INPUTS: uint32_t pid -- the process being loaded
+ *           uint32_t terminal_id -- the terminal it runs on
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: flush the TLB
+ */
+void vdso_map(uint32_t pid, uint32_t terminal_id)
+{
+  vdso_t *vdso;
+  uint64_t tsc_boot;
+
+  if (pid >= MAX_PROCESS_NUM) return;
+  vdso = &vdso_pages[pid].data;
+
+  vdso->pid = pid;
+  vdso->terminal_id = terminal_id;
+  vdso->looking_terminal = vdso_looking;
+  vdso->ticks = vdso_ticks;
+  vdso->tick_hz = VDSO_TICK_HZ;
+  vdso->tsc_khz = clock_tsc_khz();
+  tsc_boot = clock_tsc_boot();
+  vdso->tsc_boot_low = (uint32_t)tsc_boot;
+  vdso->tsc_boot_high = (uint32_t)(tsc_boot >> 32);
+
+  map_user_vdso_page(pid, (uint32_t)vdso);
+}
+
+/*
+ * vdso_tick
+ *   DESCRIPTION: called by the PIT handler, advance the tick count of
+ *                every page
+ *   INPUTS: uint32_t ticks -- VDSO_TICK_HZ ticks since the last call
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void vdso_tick(uint32_t ticks)
+{
+  uint32_t i;
+
+  vdso_ticks += ticks;
+  for (i = 0; i < MAX_PROCESS_NUM; i++)
+    vdso_pages[i].data.ticks = vdso_ticks;
+}
+
+/*
+ * vdso_set_looking
+ *   DESCRIPTION: called on a screen switch, show the new terminal in every
+ *                page
+ *   INPUTS: uint32_t terminal_id -- the terminal now on the screen
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void vdso_set_looking(uint32_t terminal_id)
+{
+  uint32_t i;
+
+  vdso_looking = terminal_id;
+  for (i = 0; i < MAX_PROCESS_NUM; i++)
+    vdso_pages[i].data.looking_terminal = terminal_id;
+}
@@ -0,0 +1,29 @@
+#ifndef VDSO_H
+#define VDSO_H
+
+#include "types.h"
+
+// the ticks of the vdso page, what pit_account counts in
+#define VDSO_TICK_HZ        100
+
+/* the page every process gets read-only at USER_VDSO_ADDR. Each field is
+ * one aligned word the kernel writes in one store, and the TSC pair never
+ * changes after boot, so a reader needs no lock */
+typedef struct vdso {
+  uint32_t pid;                       /* the program, its threads share it */
+  uint32_t terminal_id;               /* the terminal the process runs on */
+  volatile uint32_t looking_terminal; /* the terminal on the screen */
+  volatile uint32_t ticks;            /* VDSO_TICK_HZ ticks since boot */
+  uint32_t tick_hz;
+  uint32_t tsc_khz;                   /* 0 before the TSC is calibrated */
+  uint32_t tsc_boot_low;              /* the TSC the monotonic clock starts at */
+  uint32_t tsc_boot_high;
+} vdso_t;
+
+void vdso_map(uint32_t pid, uint32_t terminal_id);
+
+void vdso_tick(uint32_t ticks);
+
+void vdso_set_looking(uint32_t terminal_id);
+
+#endif
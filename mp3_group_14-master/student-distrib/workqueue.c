@@ -0,0 +1,108 @@
+#include "workqueue.h"
+#include "lib.h"
+#include "kthread.h"
+#include "spinlock.h"
+#include "schedule.h"
+
+static spinlock_t work_lock = SPINLOCK_INIT("workqueue");
+// the queue, oldest first
+static work_t *work_head = NULL;
+static work_t *work_tail = NULL;
+static int32_t kworkers[KWORKER_COUNT];
+
+/*
+ * kworker_main
+ *   DESCRIPTION: the loop of a worker thread, run the queued work oldest
+ *                first and sleep while there is none. Work runs with
+ *                interrupts on and may be preempted like a process
+ *   INPUTS: void *arg -- not used
+ *   OUTPUTS: none
+ *   RETURN VALUE: never returns
+ *   SIDE EFFECTS: none
+ */
+static void kworker_main(void *arg)
+{
+  uint32_t flags;
+  work_t *work;
+
+  while (1)
+  {
+    flags = spin_lock_irqsave(&work_lock);
+    while (work_head == NULL)
+    {
+      // interrupts stay off, so no work is queued before kthread_wait
+      spin_unlock(&work_lock);
+      kthread_wait();
+      spin_lock(&work_lock);
+    }
+    work = work_head;
+    work_head = work->next;
+    if (work_head == NULL) work_tail = NULL;
+    // from here on it may be queued again, e.g. by func itself
+    work->next = NULL;
+    work->pending = 0;
+    spin_unlock_irqrestore(&work_lock, flags);
+
+    work->func(work);
+  }
+}
+
+/*
+ * workqueue_init
+ *   DESCRIPTION: start the worker threads, they first run once the
+ *                shells are up
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: takes KWORKER_COUNT kernel threads
+ */
+void workqueue_init()
+{
+  uint32_t i;
+
+  for (i = 0; i < KWORKER_COUNT; i++)
+    kworkers[i] = kthread_create("kworker", kworker_main, NULL);
+}
+
+/*
+ * queue_work
+ *   DESCRIPTION: hand work to the worker threads, for anything too slow
+ *                for an interrupt handler or not owed to the process it
+ *                would run in. Safe from interrupt handlers
+ *   INPUTS: work_t *work -- the work, its func set
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 when queued, -1 when it is already queued or bad
+ *   SIDE EFFECTS: wakes a waiting worker
+ */
+int32_t queue_work(work_t *work)
+{
+  uint32_t flags, i;
+
+  if (work == NULL || work->func == NULL) return -1;
+
+  flags = spin_lock_irqsave(&work_lock);
+  if (work->pending)
+  {
+    spin_unlock_irqrestore(&work_lock, flags);
+    return -1;
+  }
+  work->pending = 1;
+  work->next = NULL;
+  if (work_tail == NULL)
+    work_head = work;
+  else
+    work_tail->next = work;
+  work_tail = work;
+
+  // one worker is enough, a busy one takes the work after its current item
+  for (i = 0; i < KWORKER_COUNT; i++)
+  {
+    if (kworkers[i] != KTHREAD_NONE && kthreads[kworkers[i]].waiting == YES)
+    {
+      kthread_wake(kworkers[i]);
+      break;
+    }
+  }
+  spin_unlock_irqrestore(&work_lock, flags);
+  return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "types.h"
+
+// the kernel threads taking work off the queue
+#define KWORKER_COUNT       2
+
+/* an item of background work. The poster owns it, it must stay around
+ * until func has run. func gets the item back, so it can find the data
+ * around it, and may queue it again */
+typedef struct work {
+  void (*func)(struct work *work);
+  struct work *next;
+  volatile uint32_t pending;  /* 1 from queue_work until func starts */
+} work_t;
+
+#define WORK_INIT(work_func)    { work_func, NULL, 0 }
+
+void workqueue_init();
+
+int32_t queue_work(work_t *work);
+
+#endif
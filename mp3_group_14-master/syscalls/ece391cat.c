@@ -18,6 +18,20 @@ int main ()
 	return 2;
     }
 
+    /* the kernel writes a regular file out a block at a time from the
+       image, anything else it refuses before writing a byte */
+    if (-1 != (cnt = ece391_sendfile (1, fd, 4096))) {
+        while (0 != cnt) {
+            if (-1 == cnt) {
+	        ece391_fdputs (1, (uint8_t*)"file read failed\n");
+	        return 3;
+	    }
+	    cnt = ece391_sendfile (1, fd, 4096);
+        }
+        return 0;
+    }
+
+    /* a directory or a device goes through read and write */
     while (0 != (cnt = ece391_read (fd, buf, 1024))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <sys/wait.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "ece391support.h"
@@ -225,3 +226,44 @@ ece391_close (int32_t fd)
     return 0;
 }
 
+
+void*
+ece391_sbrk (int32_t increment)
+{
+    return sbrk (increment);
+}
+
+int32_t
+ece391_clock_gettime (ece391_timespec_t* ts)
+{
+    struct timespec now;
+
+    if (-1 == clock_gettime (CLOCK_MONOTONIC, &now))
+        return -1;
+    ts->tv_sec = now.tv_sec;
+    ts->tv_nsec = now.tv_nsec;
+    return 0;
+}
+
+int32_t
+ece391_nanosleep (const ece391_timespec_t* req)
+{
+    struct timespec ts;
+
+    ts.tv_sec = req->tv_sec;
+    ts.tv_nsec = req->tv_nsec;
+    return nanosleep (&ts, NULL);
+}
+
+/* Linux has no ring to map here, callers fall back to plain reads. */
+ece391_ring_t*
+ece391_ring_setup (void)
+{
+    return (ece391_ring_t*)-1;
+}
+
+int32_t
+ece391_ring_enter (uint32_t to_submit)
+{
+    return -1;
+}
@@ -4,7 +4,7 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
-#define SBUFSIZE 33
+#define DIRBUFSIZE 1024
 
 int32_t
 do_one_file (const char* s, const char* fname) 
@@ -67,9 +67,10 @@ do_one_file (const char* s, const char* fname)
 
 int main ()
 {
-    int32_t fd, cnt;
-    uint8_t buf[SBUFSIZE];
+    int32_t fd, cnt, pos;
+    uint32_t buf[DIRBUFSIZE / sizeof (uint32_t)];
     uint8_t search[BUFSIZE];
+    ece391_dirent_t* d;
 
     if (0 != ece391_getargs (search, BUFSIZE)) {
         ece391_fdputs (1, (uint8_t*)"could not read argument\n");
@@ -81,16 +82,19 @@ int main ()
 	return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    while (0 != (cnt = ece391_getdents (fd, buf, DIRBUFSIZE))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	    return 3;
 	}
-	if ('.' == buf[0]) /* a directory... */
-	    continue;
-	buf[cnt] = '\0';
-	if (0 != do_one_file ((char*)search, (char*)buf))
-	    return 3;
+	for (pos = 0; pos < cnt; pos += d->reclen) {
+	    d = (ece391_dirent_t*)((uint8_t*)buf + pos);
+	    /* only regular files have lines, and an empty one none to match */
+	    if (DIRENT_TYPE_FILE != d->type || 0 == d->length)
+		continue;
+	    if (0 != do_one_file ((char*)search, (char*)d->name))
+		return 3;
+	}
     }
 
     return 0;
@@ -0,0 +1,95 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+/* the timer, the keyboard, COM1 and the RTC */
+static const uint32_t irqs[] = {0, 1, 4, 8};
+#define NUM_IRQS (sizeof (irqs) / sizeof (irqs[0]))
+
+static uint32_t
+cycles_to_ns (uint32_t cycles, uint32_t tsc_khz)
+{
+    uint32_t ms, us, rem;
+
+    /* a millisecond, a microsecond and a nanosecond at a time, so
+       nothing overflows 32 bits */
+    ms = cycles / tsc_khz;
+    rem = cycles % tsc_khz * 1000;
+    us = rem / tsc_khz;
+    rem = rem % tsc_khz * 1000;
+    return ms * 1000000 + us * 1000 + rem / tsc_khz;
+}
+
+static void
+put_num (uint32_t value)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_fdputs (1, ece391_itoa (value, buf, 10));
+}
+
+static void
+print_irq (uint32_t irq, ece391_irqstat_t* st)
+{
+    uint32_t i;
+
+    ece391_fdputs (1, (uint8_t*)"irq ");
+    put_num (irq);
+    ece391_fdputs (1, (uint8_t*)": ");
+    put_num (st->count);
+    ece391_fdputs (1, (uint8_t*)" interrupts, ");
+    put_num (st->overruns);
+    ece391_fdputs (1, (uint8_t*)" overruns, max latency ");
+    put_num (cycles_to_ns (st->max_latency, st->tsc_khz));
+    ece391_fdputs (1, (uint8_t*)" ns, max handler ");
+    put_num (cycles_to_ns (st->max_handler, st->tsc_khz));
+    ece391_fdputs (1, (uint8_t*)" ns\n");
+
+    for (i = 0; i < IRQSTAT_BUCKETS; i++) {
+        if (st->latency[i] == 0 && st->handler[i] == 0)
+            continue;
+        if (i < IRQSTAT_BUCKETS - 1) {
+            ece391_fdputs (1, (uint8_t*)"  < ");
+            put_num (cycles_to_ns (1 << (IRQSTAT_SHIFT + i), st->tsc_khz));
+            ece391_fdputs (1, (uint8_t*)" ns: ");
+        } else {
+            ece391_fdputs (1, (uint8_t*)"  longer: ");
+        }
+        put_num (st->latency[i]);
+        ece391_fdputs (1, (uint8_t*)" waited, ");
+        put_num (st->handler[i]);
+        ece391_fdputs (1, (uint8_t*)" handled\n");
+    }
+}
+
+int main ()
+{
+    uint32_t i;
+    uint8_t buf[BUFSIZE];
+    ece391_irqstat_t st;
+
+    if (0 == ece391_getargs (buf, BUFSIZE)) {
+        if (0 != ece391_strcmp (buf, (uint8_t*)"reset")) {
+            ece391_fdputs (1, (uint8_t*)"usage: irqstat [reset]\n");
+            return 3;
+        }
+        for (i = 0; i < NUM_IRQS; i++)
+            ece391_irqstat (irqs[i], 0);
+        return 0;
+    }
+
+    for (i = 0; i < NUM_IRQS; i++) {
+        if (-1 == ece391_irqstat (irqs[i], &st)) {
+            ece391_fdputs (1, (uint8_t*)"irqstat call failed\n");
+            return 3;
+        }
+        if (st.count == 0 || st.tsc_khz == 0)
+            continue;
+        print_irq (irqs[i], &st);
+    }
+
+    return 0;
+}
@@ -4,25 +4,63 @@
 #include "ece391syscall.h"
 
 #define SBUFSIZE 33
+#define DIRBUFSIZE 1024
+#define NUMBUFSIZE 11
+#define LENGTH_WIDTH 8
+
+/* "ls -l" also prints the type and length, which getdents hands back
+   with every name */
+static void
+print_long (ece391_dirent_t* d)
+{
+    static const char types[] = "rdf";
+    uint8_t num[NUMBUFSIZE];
+    uint32_t pad;
+
+    num[0] = (d->type <= DIRENT_TYPE_FILE) ? types[d->type] : '?';
+    num[1] = ' ';
+    (void)ece391_write (1, num, 2);
+    ece391_itoa (d->length, num, 10);
+    for (pad = ece391_strlen (num); pad < LENGTH_WIDTH; pad++)
+        ece391_fdputs (1, (uint8_t*)" ");
+    ece391_fdputs (1, num);
+    ece391_fdputs (1, (uint8_t*)" ");
+}
 
 int main ()
 {
-    int32_t fd, cnt;
-    uint8_t buf[SBUFSIZE];
+    int32_t fd, cnt, pos, long_format = 0;
+    uint32_t buf[DIRBUFSIZE / sizeof (uint32_t)];
+    uint8_t args[SBUFSIZE];
+    ece391_dirent_t* d;
+
+    if (0 == ece391_getargs (args, SBUFSIZE)) {
+        if (0 != ece391_strcmp (args, (uint8_t*)"-l")) {
+            ece391_fdputs (1, (uint8_t*)"usage: ls [-l]\n");
+            return 3;
+        }
+        long_format = 1;
+    }
 
     if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
         ece391_fdputs (1, (uint8_t*)"directory open failed\n");
         return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    /* many entries per call instead of one read per name */
+    while (0 != (cnt = ece391_getdents (fd, buf, DIRBUFSIZE))) {
         if (-1 == cnt) {
-	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
-	        return 3;
-	    }
-	    buf[cnt] = '\n';
-	    if (-1 == ece391_write (1, buf, cnt + 1))
-	        return 3;
+            ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
+            return 3;
+        }
+        for (pos = 0; pos < cnt; pos += d->reclen) {
+            d = (ece391_dirent_t*)((uint8_t*)buf + pos);
+            if (long_format)
+                print_long (d);
+            d->name[d->namelen] = '\n';
+            if (-1 == ece391_write (1, d->name, d->namelen + 1))
+                return 3;
+        }
     }
 
     return 0;
@@ -0,0 +1,37 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+int main ()
+{
+    int32_t cmd, cnt;
+    uint8_t buf[BUFSIZE];
+
+    if (0 != ece391_getargs (buf, BUFSIZE)) {
+        ece391_fdputs (1, (uint8_t*)"usage: prof start|stop|dump\n");
+        return 3;
+    }
+
+    if (0 == ece391_strcmp (buf, (uint8_t*)"start"))
+        cmd = PROFILE_START;
+    else if (0 == ece391_strcmp (buf, (uint8_t*)"stop"))
+        cmd = PROFILE_STOP;
+    else if (0 == ece391_strcmp (buf, (uint8_t*)"dump"))
+        cmd = PROFILE_DUMP;
+    else {
+        ece391_fdputs (1, (uint8_t*)"usage: prof start|stop|dump\n");
+        return 3;
+    }
+
+    if (-1 == (cnt = ece391_profile (cmd))) {
+        ece391_fdputs (1, (uint8_t*)"profile call failed\n");
+        return 3;
+    }
+    ece391_fdputs (1, ece391_itoa (cnt, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" samples\n");
+
+    return 0;
+}
@@ -102,3 +102,246 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+/* Every heap block starts with this header, blocks are kept in address order */
+typedef struct heap_block {
+    uint32_t size;
+    uint32_t free;
+    struct heap_block* next;
+} heap_block_t;
+
+#define HEAP_ALIGN 8
+
+static heap_block_t* heap_head = 0;
+static heap_block_t* heap_tail = 0;
+/* threads share the heap */
+static ece391_mutex_t heap_lock;
+
+/* First-fit allocator on top of the sbrk system call */
+void* ece391_malloc(uint32_t size)
+{
+    heap_block_t* block;
+    heap_block_t* rest;
+
+    if (0 == size)
+        return 0;
+    size = (size + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
+    ece391_mutex_lock(&heap_lock);
+
+    /* reuse a free block, splitting it if the rest is big enough */
+    for (block = heap_head; 0 != block; block = block->next) {
+        if (!block->free || block->size < size)
+            continue;
+        if (block->size >= size + sizeof(heap_block_t) + HEAP_ALIGN) {
+            rest = (heap_block_t*)((uint8_t*)(block + 1) + size);
+            rest->size = block->size - size - sizeof(heap_block_t);
+            rest->free = 1;
+            rest->next = block->next;
+            if (heap_tail == block)
+                heap_tail = rest;
+            block->next = rest;
+            block->size = size;
+        }
+        block->free = 0;
+        ece391_mutex_unlock(&heap_lock);
+        return block + 1;
+    }
+
+    /* otherwise grow the heap */
+    block = ece391_sbrk(sizeof(heap_block_t) + size);
+    if ((void*)-1 == block) {
+        ece391_mutex_unlock(&heap_lock);
+        return 0;
+    }
+    block->size = size;
+    block->free = 0;
+    block->next = 0;
+    if (0 == heap_head)
+        heap_head = block;
+    else
+        heap_tail->next = block;
+    heap_tail = block;
+    ece391_mutex_unlock(&heap_lock);
+    return block + 1;
+}
+
+/* Mark a block free and merge it with the free blocks that follow it */
+void ece391_free(void* ptr)
+{
+    heap_block_t* block;
+
+    if (0 == ptr)
+        return;
+    ece391_mutex_lock(&heap_lock);
+    block = (heap_block_t*)ptr - 1;
+    block->free = 1;
+    while (0 != block->next && block->next->free) {
+        if (heap_tail == block->next)
+            heap_tail = block;
+        block->size += sizeof(heap_block_t) + block->next->size;
+        block->next = block->next->next;
+    }
+    ece391_mutex_unlock(&heap_lock);
+}
+
+#define MS_PER_SEC 1000
+#define NS_PER_MS  1000000
+
+/* The vdso page of this process */
+const ece391_vdso_t* ece391_vdso(void)
+{
+    return (const ece391_vdso_t*)ECE391_VDSO_ADDR;
+}
+
+/* The pid of the program, a thread gets the same one */
+int32_t ece391_getpid(void)
+{
+    return ece391_vdso()->pid;
+}
+
+/* The terminal this process runs on, not the one on the screen */
+int32_t ece391_get_terminal(void)
+{
+    return ece391_vdso()->terminal_id;
+}
+
+uint32_t ece391_ticks(void)
+{
+    return ece391_vdso()->ticks;
+}
+
+/* clock_gettime without a trap, from the TSC and the calibration in the
+ * vdso page.  Programs do not link libgcc, so the 64-bit division is
+ * done with divl, high half first so it cannot overflow. */
+int32_t ece391_vdso_gettime(ece391_timespec_t* ts)
+{
+    const ece391_vdso_t* vdso = ece391_vdso();
+    uint32_t low, high, khz, ms, rem, sec, ms_rem, ns_high, ns_low;
+
+    khz = vdso->tsc_khz;
+    if (0 == khz)
+        return ece391_clock_gettime(ts);
+
+    asm volatile ("rdtsc" : "=a"(low), "=d"(high));
+    high -= vdso->tsc_boot_high + (low < vdso->tsc_boot_low);
+    low -= vdso->tsc_boot_low;
+
+    /* cycles to milliseconds, past 2^32 ms (49 days) the count wraps */
+    high %= khz;
+    asm ("divl %4" : "=a"(ms), "=d"(rem) : "a"(low), "d"(high), "rm"(khz));
+    sec = ms / MS_PER_SEC;
+    ms_rem = ms % MS_PER_SEC;
+
+    /* the cycles left over, rem < khz, to nanoseconds */
+    asm ("mull %3" : "=a"(ns_low), "=d"(ns_high) : "a"(rem), "rm"(NS_PER_MS));
+    asm ("divl %4" : "=a"(ns_low), "=d"(rem) : "a"(ns_low), "d"(ns_high), "rm"(khz));
+
+    ts->tv_sec = sec;
+    ts->tv_nsec = ms_rem * NS_PER_MS + ns_low;
+    return 0;
+}
+
+/* Atomic exchange and compare-and-exchange of a word, the lock prefix
+ * keeps them atomic against other processors too. */
+static uint32_t atomic_xchg(volatile uint32_t* p, uint32_t val)
+{
+    asm volatile ("xchgl %0, %1" : "+r"(val), "+m"(*p) : : "memory");
+    return val;
+}
+
+static uint32_t atomic_cmpxchg(volatile uint32_t* p, uint32_t old, uint32_t val)
+{
+    uint32_t prev;
+
+    asm volatile ("lock; cmpxchgl %2, %1"
+                  : "=a"(prev), "+m"(*p) : "r"(val), "0"(old) : "memory");
+    return prev;
+}
+
+/* A free mutex is taken without a system call.  A thread that finds it
+ * held marks it contended and sleeps, so only an unlock that sees the mark
+ * has to wake one up. */
+void ece391_mutex_lock(ece391_mutex_t* m)
+{
+    uint32_t c;
+
+    if (0 == (c = atomic_cmpxchg(&m->state, 0, 1)))
+        return;
+    if (2 != c)
+        c = atomic_xchg(&m->state, 2);
+    while (0 != c) {
+        ece391_futex_wait(&m->state, 2);
+        c = atomic_xchg(&m->state, 2);
+    }
+}
+
+void ece391_mutex_unlock(ece391_mutex_t* m)
+{
+    if (2 == atomic_xchg(&m->state, 0))
+        ece391_futex_wake(&m->state, 1);
+}
+
+/* A waiter sleeps on the sequence number it saw before letting go of the
+ * mutex, so a signal between the two makes its futex_wait return at once. */
+void ece391_cond_wait(ece391_cond_t* c, ece391_mutex_t* m)
+{
+    uint32_t seq = c->seq;
+
+    ece391_mutex_unlock(m);
+    ece391_futex_wait(&c->seq, seq);
+    ece391_mutex_lock(m);
+}
+
+void ece391_cond_signal(ece391_cond_t* c)
+{
+    asm volatile ("lock; incl %0" : "+m"(c->seq) : : "memory");
+    ece391_futex_wake(&c->seq, 1);
+}
+
+void ece391_cond_broadcast(ece391_cond_t* c)
+{
+    asm volatile ("lock; incl %0" : "+m"(c->seq) : : "memory");
+    ece391_futex_wake(&c->seq, FUTEX_WAKE_ALL);
+}
+
+/* The first function of every thread, it halts the thread when fn returns */
+static void thread_start(void* arg)
+{
+    ece391_thread_t* t = arg;
+
+    t->fn(t->arg);
+    ece391_halt(0);
+}
+
+/* Start fn(arg) in a thread with a stack from the heap.  The thread runs
+ * on the terminal of the program, taking turns with its other threads. */
+int32_t ece391_thread_create(ece391_thread_t* t, void (*fn)(void*), void* arg)
+{
+    uint32_t* top;
+
+    t->fn = fn;
+    t->arg = arg;
+    t->stack = ece391_malloc(ECE391_THREAD_STACK);
+    if (0 == t->stack)
+        return -1;
+
+    /* thread_start finds its argument above a return address it never uses */
+    top = (uint32_t*)((uint8_t*)t->stack + ECE391_THREAD_STACK);
+    *--top = (uint32_t)t;
+    *--top = 0;
+    if (-1 == ece391_clone(thread_start, top, &t->tid)) {
+        ece391_free(t->stack);
+        return -1;
+    }
+    return 0;
+}
+
+/* Wait for a thread to halt, the kernel clears its tid once the thread is
+ * off its stack, so the stack can be freed then. */
+void ece391_thread_join(ece391_thread_t* t)
+{
+    uint32_t tid;
+
+    while (0 != (tid = t->tid))
+        ece391_futex_wait(&t->tid, tid);
+    ece391_free(t->stack);
+}
@@ -1,6 +1,10 @@
 #if !defined(ECE391SUPPORT_H)
 #define ECE391SUPPORT_H
 
+/* defined in ece391syscall.h */
+struct ece391_vdso;
+struct ece391_timespec;
+
 extern uint32_t ece391_strlen(const uint8_t* s);
 extern void ece391_strcpy(uint8_t* dst, const uint8_t* src);
 extern void ece391_fdputs(int32_t fd, const uint8_t* s);
@@ -8,6 +12,39 @@ extern int32_t ece391_strcmp(const uint8_t* s1, const uint8_t* s2);
 extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
+extern void* ece391_malloc(uint32_t size);
+extern void ece391_free(void* ptr);
+extern const struct ece391_vdso* ece391_vdso(void);
+extern int32_t ece391_getpid(void);
+extern int32_t ece391_get_terminal(void);
+extern uint32_t ece391_ticks(void);
+extern int32_t ece391_vdso_gettime(struct ece391_timespec* ts);
+
+/* Threads on top of clone, and a mutex and condition variable on top of
+ * the futex calls.  Both start out zeroed. */
+typedef struct ece391_mutex {
+    volatile uint32_t state;    /* 0 free, 1 held, 2 held with waiters */
+} ece391_mutex_t;
+
+typedef struct ece391_cond {
+    volatile uint32_t seq;      /* bumped by every signal */
+} ece391_cond_t;
+
+#define ECE391_THREAD_STACK 8192
+typedef struct ece391_thread {
+    volatile uint32_t tid;      /* 0 once the thread halted */
+    void (*fn)(void*);
+    void* arg;
+    void* stack;
+} ece391_thread_t;
+
+extern int32_t ece391_thread_create(ece391_thread_t* t, void (*fn)(void*), void* arg);
+extern void ece391_thread_join(ece391_thread_t* t);
+extern void ece391_mutex_lock(ece391_mutex_t* m);
+extern void ece391_mutex_unlock(ece391_mutex_t* m);
+extern void ece391_cond_wait(ece391_cond_t* c, ece391_mutex_t* m);
+extern void ece391_cond_signal(ece391_cond_t* c);
+extern void ece391_cond_broadcast(ece391_cond_t* c);
 
 #endif /* ECE391SUPPORT_H */
 
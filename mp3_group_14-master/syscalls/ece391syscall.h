@@ -3,7 +3,139 @@
 
 #include <stdint.h>
 
-/* All calls return >= 0 on success or -1 on failure. */
+/* Time since boot for clock_gettime, or a duration for nanosleep. */
+typedef struct ece391_timespec {
+    uint32_t tv_sec;
+    uint32_t tv_nsec;
+} ece391_timespec_t;
+
+/* Commands of the profile call, the profile goes out on COM1. */
+#define PROFILE_START 0
+#define PROFILE_STOP  1
+#define PROFILE_DUMP  2
+
+/* Latency statistics of one irq line, times in TSC cycles. Histogram
+ * bucket 0 is below 2^IRQSTAT_SHIFT cycles, each next one twice as long,
+ * the last one is everything longer. */
+#define IRQSTAT_BUCKETS 16
+#define IRQSTAT_SHIFT   8
+typedef struct ece391_irqstat {
+    uint32_t tsc_khz;
+    uint32_t count;
+    uint32_t overruns;
+    uint32_t max_latency;
+    uint32_t max_handler;
+    uint32_t latency[IRQSTAT_BUCKETS];
+    uint32_t handler[IRQSTAT_BUCKETS];
+} ece391_irqstat_t;
+
+/* One descriptor for poll; revents gets the events of events that
+ * happened, or POLLNVAL for a descriptor that is not open. */
+#define POLLIN   0x0001
+#define POLLOUT  0x0004
+#define POLLNVAL 0x0020
+typedef struct ece391_pollfd {
+    int32_t fd;
+    int16_t events;
+    int16_t revents;
+} ece391_pollfd_t;
+
+/* Commands and flags of fcntl.  A read on an O_NONBLOCK descriptor of the
+ * terminal, the rtc or the serial port returns -EAGAIN instead of waiting
+ * for a line, a tick or a byte. */
+#define F_GETFL    3
+#define F_SETFL    4
+/* the Linux values, which the emulation gets from its own headers */
+#if !defined(O_NONBLOCK)
+#define O_NONBLOCK 0x0800
+#endif
+#if !defined(EAGAIN)
+#define EAGAIN     11
+#endif
+
+/* The rings ring_setup maps.  Fill sq[sq_tail % RING_ENTRIES] and bump
+ * sq_tail to queue a read or a write, ring_enter runs the queued ones and
+ * bumps cq_tail once per completion, bump cq_head after reading one.
+ * Indices run free. */
+#define RING_ENTRIES  128
+#define RING_OP_NOP   0
+#define RING_OP_READ  1
+#define RING_OP_WRITE 2
+typedef struct ece391_sqe {
+    uint32_t opcode;
+    int32_t fd;
+    void* buf;
+    int32_t len;
+    uint32_t user_data;
+} ece391_sqe_t;
+typedef struct ece391_cqe {
+    uint32_t user_data;
+    int32_t result;
+} ece391_cqe_t;
+typedef struct ece391_ring {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    ece391_sqe_t sq[RING_ENTRIES];
+    ece391_cqe_t cq[RING_ENTRIES];
+} ece391_ring_t;
+
+/* The page the kernel maps read-only into every process, read it with the
+ * helpers of ece391support.c instead of a system call.  ticks counts at
+ * tick_hz, the TSC counts tsc_khz cycles per millisecond from tsc_boot.
+ * pid is the program, the same in all of its threads. */
+#define ECE391_VDSO_ADDR 0x084C1000
+typedef struct ece391_vdso {
+    uint32_t pid;
+    uint32_t terminal_id;
+    volatile uint32_t looking_terminal;
+    volatile uint32_t ticks;
+    uint32_t tick_hz;
+    uint32_t tsc_khz;
+    uint32_t tsc_boot_low;
+    uint32_t tsc_boot_high;
+} ece391_vdso_t;
+
+/* A record of getdents.  The name is NUL terminated, the next record
+ * starts reclen bytes further. */
+#define DIRENT_TYPE_RTC  0
+#define DIRENT_TYPE_DIR  1
+#define DIRENT_TYPE_FILE 2
+typedef struct ece391_dirent {
+    uint16_t reclen;
+    uint8_t type;
+    uint8_t namelen;
+    uint32_t inode;
+    uint32_t length;
+    uint8_t name[];
+} ece391_dirent_t;
+
+/* What procstat copies out for one running process.  ticks counts the
+ * vdso tick_hz ticks it was found running in. */
+#define PROCSTAT_MAX      6
+#define PROCSTAT_NAME_LEN 32
+typedef struct ece391_procstat {
+    uint32_t pid;
+    uint32_t parent_pid;
+    uint32_t terminal_id;
+    uint32_t ticks;
+    uint32_t switches;
+    uint32_t syscalls;
+    uint32_t page_faults;
+    int8_t name[PROCSTAT_NAME_LEN + 1];
+} ece391_procstat_t;
+
+/* clone starts a thread of the program at entry on the given stack.  It
+ * writes the pid of the thread to *tid, the only place a thread finds its
+ * own id as ece391_getpid gives that of the program, and clears it with a
+ * futex_wake when the thread halts.  futex_wait sleeps while *addr holds
+ * val, until a futex_wake on addr, which wakes up to count threads. */
+#define FUTEX_WAKE_ALL    0xFFFFFFFF
+
+/* All calls return >= 0 on success or -1 on failure, except the
+ * -EAGAIN of a read on an O_NONBLOCK descriptor and of a futex_wait
+ * on a word that changed. */
 
 /*  
  * Note that the system call for halt will have to make sure that only
@@ -21,6 +153,22 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+extern int32_t ece391_mmap (int32_t fd, uint32_t length, uint8_t** map_start);
+extern void* ece391_sbrk (int32_t increment);
+extern int32_t ece391_clock_gettime (ece391_timespec_t* ts);
+extern int32_t ece391_nanosleep (const ece391_timespec_t* req);
+extern int32_t ece391_profile (int32_t cmd);
+extern int32_t ece391_irqstat (uint32_t irq, ece391_irqstat_t* buf);
+extern int32_t ece391_poll (ece391_pollfd_t* fds, uint32_t nfds, int32_t timeout_ms);
+extern int32_t ece391_fcntl (int32_t fd, uint32_t cmd, uint32_t arg);
+extern ece391_ring_t* ece391_ring_setup (void);
+extern int32_t ece391_ring_enter (uint32_t to_submit);
+extern int32_t ece391_getdents (int32_t fd, void* buf, int32_t nbytes);
+extern int32_t ece391_sendfile (int32_t out_fd, int32_t in_fd, int32_t count);
+extern int32_t ece391_procstat (ece391_procstat_t* buf, uint32_t count);
+extern int32_t ece391_clone (void (*entry)(void*), void* stack, volatile uint32_t* tid);
+extern int32_t ece391_futex_wait (volatile uint32_t* addr, uint32_t val);
+extern int32_t ece391_futex_wake (volatile uint32_t* addr, uint32_t count);
 
 enum signums {
 	DIV_ZERO = 0,
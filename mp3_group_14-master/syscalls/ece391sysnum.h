@@ -11,5 +11,21 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_MMAP    11
+#define SYS_SBRK    12
+#define SYS_CLOCK_GETTIME 13
+#define SYS_NANOSLEEP 14
+#define SYS_PROFILE 15
+#define SYS_IRQSTAT 16
+#define SYS_POLL    17
+#define SYS_FCNTL   18
+#define SYS_RING_SETUP 19
+#define SYS_RING_ENTER 20
+#define SYS_GETDENTS 21
+#define SYS_SENDFILE 22
+#define SYS_PROCSTAT 23
+#define SYS_CLONE   24
+#define SYS_FUTEX_WAIT 25
+#define SYS_FUTEX_WAKE 26
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,116 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+/* the three shells and this program leave two pids for threads */
+#define NUM_WORKERS 2
+#define QUEUE_SIZE 8
+#define NUM_ITEMS 2000
+#define ITEM_WORK 500
+
+/* a bounded queue the main thread fills and the workers drain */
+static uint32_t queue[QUEUE_SIZE];
+static uint32_t head, count;
+static int32_t done;
+static ece391_mutex_t lock;
+static ece391_cond_t not_empty, not_full;
+
+static uint32_t sums[NUM_WORKERS];
+static uint32_t items[NUM_WORKERS];
+static volatile uint32_t sink;
+
+static void
+put_num (uint32_t value)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_fdputs (1, ece391_itoa (value, buf, 10));
+}
+
+/* something to chew on per item, so the workers take turns mid-item */
+static void
+work (uint32_t item)
+{
+    uint32_t i, x = item;
+
+    for (i = 0; i < ITEM_WORK; i++)
+        x = x * 1103515245 + 12345;
+    sink = x;
+}
+
+static void
+worker (void* arg)
+{
+    uint32_t id = (uint32_t)arg, item;
+
+    while (1) {
+        ece391_mutex_lock (&lock);
+        while (0 == count && !done)
+            ece391_cond_wait (&not_empty, &lock);
+        if (0 == count) {
+            ece391_mutex_unlock (&lock);
+            return;
+        }
+        item = queue[head];
+        head = (head + 1) % QUEUE_SIZE;
+        count--;
+        ece391_cond_signal (&not_full);
+        ece391_mutex_unlock (&lock);
+
+        work (item);
+        sums[id] += item;
+        items[id]++;
+    }
+}
+
+int main ()
+{
+    uint32_t i, total = 0, expected = 0;
+    ece391_thread_t threads[NUM_WORKERS];
+
+    for (i = 0; i < NUM_WORKERS; i++) {
+        if (-1 == ece391_thread_create (&threads[i], worker, (void*)i)) {
+            ece391_fdputs (1, (uint8_t*)"thread create failed\n");
+            return 3;
+        }
+    }
+
+    for (i = 1; i <= NUM_ITEMS; i++) {
+        ece391_mutex_lock (&lock);
+        while (QUEUE_SIZE == count)
+            ece391_cond_wait (&not_full, &lock);
+        queue[(head + count) % QUEUE_SIZE] = i;
+        count++;
+        ece391_cond_signal (&not_empty);
+        ece391_mutex_unlock (&lock);
+        expected += i;
+    }
+
+    ece391_mutex_lock (&lock);
+    done = 1;
+    ece391_cond_broadcast (&not_empty);
+    ece391_mutex_unlock (&lock);
+
+    for (i = 0; i < NUM_WORKERS; i++) {
+        ece391_thread_join (&threads[i]);
+        ece391_fdputs (1, (uint8_t*)"worker ");
+        put_num (i);
+        ece391_fdputs (1, (uint8_t*)": ");
+        put_num (items[i]);
+        ece391_fdputs (1, (uint8_t*)" items\n");
+        total += sums[i];
+    }
+
+    ece391_fdputs (1, (uint8_t*)"sum ");
+    put_num (total);
+    if (total != expected) {
+        ece391_fdputs (1, (uint8_t*)", expected ");
+        put_num (expected);
+        ece391_fdputs (1, (uint8_t*)"\n");
+        return 1;
+    }
+    ece391_fdputs (1, (uint8_t*)", ok\n");
+    return 0;
+}
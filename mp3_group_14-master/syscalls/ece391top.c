@@ -0,0 +1,169 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+#define SCREEN_COLS 80
+#define SCREEN_ROWS 25
+#define ATTRIB 0x7
+#define NUM_TERMINALS 3
+/* refresh once a second */
+#define REFRESH_NS 1000000000
+
+/* column where each field of a process line ends, the name starts after */
+#define COL_PID     5
+#define COL_PPID    11
+#define COL_TERM    17
+#define COL_CPU     23
+#define COL_TICKS   33
+#define COL_SWITCH  41
+#define COL_SYSCALL 51
+#define COL_PGFAULT 60
+#define COL_NAME    62
+
+static uint8_t* screen;
+
+static void
+put_str (uint32_t row, uint32_t col, const uint8_t* s)
+{
+    while (*s != '\0' && col < SCREEN_COLS) {
+        screen[(row * SCREEN_COLS + col) << 1] = *s++;
+        screen[((row * SCREEN_COLS + col) << 1) + 1] = ATTRIB;
+        col++;
+    }
+}
+
+/* print a number ending just before column end */
+static void
+put_num (uint32_t row, uint32_t end, uint32_t value)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_itoa (value, buf, 10);
+    put_str (row, end - ece391_strlen (buf), buf);
+}
+
+static void
+clear_row (uint32_t row)
+{
+    uint32_t col;
+
+    for (col = 0; col < SCREEN_COLS; col++) {
+        screen[(row * SCREEN_COLS + col) << 1] = ' ';
+        screen[((row * SCREEN_COLS + col) << 1) + 1] = ATTRIB;
+    }
+}
+
+/* the ticks a process ran since the last refresh, all of them for a
+   process that was not there then */
+static uint32_t
+ticks_since (ece391_procstat_t* st, ece391_procstat_t* prev, int32_t nprev)
+{
+    int32_t i;
+
+    for (i = 0; i < nprev; i++) {
+        if (prev[i].pid == st->pid &&
+            0 == ece391_strcmp ((uint8_t*)prev[i].name, (uint8_t*)st->name) &&
+            prev[i].ticks <= st->ticks)
+            return st->ticks - prev[i].ticks;
+    }
+    return st->ticks;
+}
+
+int main ()
+{
+    int32_t i, n, nprev = 0, row;
+    uint32_t now, then, elapsed, busy, delta;
+    uint32_t per_term[NUM_TERMINALS];
+    uint8_t buf[BUFSIZE];
+    ece391_procstat_t stats[2][PROCSTAT_MAX];
+    ece391_procstat_t *cur = stats[0], *prev = stats[1], *swap;
+    ece391_timespec_t ts = {0, REFRESH_NS};
+
+    if (-1 == ece391_vidmap (&screen)) {
+        ece391_fdputs (1, (uint8_t*)"vidmap failed\n");
+        return 3;
+    }
+    /* a line typed on stdin ends top, without waiting for one */
+    ece391_fcntl (0, F_SETFL, O_NONBLOCK);
+
+    for (row = 0; row < SCREEN_ROWS; row++)
+        clear_row (row);
+    then = ece391_ticks ();
+
+    while (1) {
+        if (-1 == (n = ece391_procstat (cur, PROCSTAT_MAX))) {
+            ece391_fdputs (1, (uint8_t*)"procstat call failed\n");
+            return 3;
+        }
+        now = ece391_ticks ();
+        elapsed = now - then;
+        if (elapsed == 0)
+            elapsed = 1;
+
+        for (i = 0; i < NUM_TERMINALS; i++)
+            per_term[i] = 0;
+        busy = 0;
+        for (row = 0; row < 2 + NUM_TERMINALS + PROCSTAT_MAX; row++)
+            clear_row (row);
+
+        row = 3;
+        put_str (row, COL_PID - 3, (uint8_t*)"PID");
+        put_str (row, COL_PPID - 4, (uint8_t*)"PPID");
+        put_str (row, COL_TERM - 4, (uint8_t*)"TERM");
+        put_str (row, COL_CPU - 4, (uint8_t*)"CPU%");
+        put_str (row, COL_TICKS - 5, (uint8_t*)"TICKS");
+        put_str (row, COL_SWITCH - 6, (uint8_t*)"SWITCH");
+        put_str (row, COL_SYSCALL - 7, (uint8_t*)"SYSCALL");
+        put_str (row, COL_PGFAULT - 7, (uint8_t*)"PGFAULT");
+        put_str (row, COL_NAME, (uint8_t*)"NAME");
+        for (i = 0; i < n; i++) {
+            delta = ticks_since (&cur[i], prev, nprev);
+            busy += delta;
+            if (cur[i].terminal_id < NUM_TERMINALS)
+                per_term[cur[i].terminal_id] += delta;
+            row = 4 + i;
+            put_num (row, COL_PID, cur[i].pid);
+            if (cur[i].parent_pid != (uint32_t)-1)
+                put_num (row, COL_PPID, cur[i].parent_pid);
+            put_num (row, COL_TERM, cur[i].terminal_id);
+            put_num (row, COL_CPU, delta * 100 / elapsed);
+            put_num (row, COL_TICKS, cur[i].ticks);
+            put_num (row, COL_SWITCH, cur[i].switches);
+            put_num (row, COL_SYSCALL, cur[i].syscalls);
+            put_num (row, COL_PGFAULT, cur[i].page_faults);
+            put_str (row, COL_NAME, (uint8_t*)cur[i].name);
+        }
+
+        put_str (0, 0, (uint8_t*)"top - up");
+        put_num (0, 16, now / ece391_vdso ()->tick_hz);
+        put_str (0, 16, (uint8_t*)"s,");
+        put_num (0, 21, n);
+        put_str (0, 22, (uint8_t*)"processes, idle");
+        put_num (0, 41, busy < elapsed ? (elapsed - busy) * 100 / elapsed : 0);
+        put_str (0, 41, (uint8_t*)"%");
+        put_str (0, 50, (uint8_t*)"press enter to quit");
+        for (i = 0; i < NUM_TERMINALS; i++) {
+            put_str (1, i * 16, (uint8_t*)"term");
+            put_num (1, i * 16 + 6, i);
+            put_str (1, i * 16 + 6, (uint8_t*)":");
+            put_num (1, i * 16 + 11, per_term[i] * 100 / elapsed);
+            put_str (1, i * 16 + 11, (uint8_t*)"%");
+        }
+
+        /* this snapshot is the one the next refresh compares with */
+        swap = prev;
+        prev = cur;
+        cur = swap;
+        nprev = n;
+        then = now;
+
+        if (0 < ece391_read (0, buf, BUFSIZE))
+            break;
+        ece391_nanosleep (&ts);
+    }
+
+    ece391_fcntl (0, F_SETFL, 0);
+    return 0;
+}